@@ -10,34 +10,70 @@
 #include <algorithm> // shuffle
 #include <random>    // default_random_engine
 #include <chrono>    // chrono::system_clock
+#include <memory>    // unique_ptr
+#include <atomic>
+#include <cmath>     // log, sqrt
 #include "cursor.hpp"
 #include "player.hpp"
+#include "parallel.hpp"
+#include "fixedboard.hpp"
 using namespace std;
 
 //-------------------------------------------------------------------
 // AIMonteCarloPlayer: uses the Monte Carlo  method to select the next
-// move. To make a move, the steps  I follow are: (1) initially have a
-// scratchpad board  (another instance of  the board, where  we simply
-// update the states  of the vertices, according to  the current state
-// of the gameboard); (2) obtain a list of the free positions; (3) for
-// each  free position,  assume  it  is fixed  and  do  a Monte  Carlo
-// simulation to  find out how many  times it would win;  (4) pick the
-// move  that provides  the  largest number  of  successes across  all
-// simulations.
+// move. To make a move, the steps  I follow are: (1) initially take a
+// scratchpad copy of the position of the gameboard (a HexPosition, a
+// small value that holds the stones, the turn and the hash; the board
+// topology is shared with the gameboard); (2) obtain a list of the free
+// positions; (3) for each free position, assume it is fixed and do a
+// Monte Carlo simulation to find out how many times it would win; (4)
+// pick the move that provides the largest number of successes across
+// all simulations. The positions need bitboards, so the player works on
+// boards of up to BB_MAX_DIM.
 
 // A  Monte Carlo  simulation  consists of  the  following steps:  (1)
 // assume that we will make one move into a free board position (fixed
-// move), so  we mark that position  on the scratchpad board  with the
+// move), so  we mark that position  on a copy of the scratchpad with the
 // symbol of the current player; (2) create a copy of the list of free
 // positions without  the fixed  move (temp);  (3) shuffle  the 'temp'
-// list and  traverse it once,  assigning moves to  alternate players,
-// begining with  the symbol  of the opponent;  (4) evaluate  (using a
-// color-aware depth-first search from top-left to bottom-right to see
-// if the current player won  (update victories accordingly); (5) undo
-// the  simulation  moves (except  the  fixed  move); for  efficiency,
-// traverse 'temp' again  filling the positions with  blank again; (6)
-// go to  step (3) until  we reach the  desired number of  trials; (7)
-// return the number of victories across all number of trials.
+// list and  traverse it once  over a fresh copy of the fixed position,
+// assigning moves to  alternate players, begining with  the symbol  of
+// the opponent;  (4) evaluate  (using a bit-parallel flood fill over the
+// position's bitboard) to see if the current player won (update
+// victories accordingly); (5) go to  step (3) until  we reach the
+// desired number of  trials (copying the fixed position is a memcpy, so
+// there is nothing to undo); (6) return the number of victories across
+// all number of trials.
+
+// Random games  almost fill the board  before anyone connects, so for
+// the playouts we fill the whole  board and test for victory once, which
+// is cheaper than tracking connectivity after each stone. The playouts
+// run on a FixedHexBoard<N> (see dispatch_board_size), whose copies and
+// flood fills have every size-dependent quantity as a constant; sizes
+// without one use HexPositions instead. Both list the free positions in
+// the same order, so they play exactly the same games.
+
+// The simulations of different  moves are independent, so they are spread
+// over a pool of threads (one per core by default) that lives as long as
+// the player. Each thread has its own scratch space, and each move its own
+// random number generator, seeded from a seed drawn once per turn plus
+// the vertex of the move; the results of the moves are then compared in
+// order. Therefore the move chosen depends only on that seed, not on the
+// number of threads or on their timing.
+
+// Giving every move the same number of trials wastes most of them: after a
+// few dozen playouts the bad moves are obviously bad, and they cost as
+// much as the good ones. So by default the player spends a total budget of
+// playouts per turn by successive halving: the budget is split evenly into
+// about log2(moves) rounds; in each round the moves still in the running
+// get the same share of the playouts of that round, and then the worse
+// half of them (by win rate over all their playouts so far) is dropped,
+// as is any move whose upper confidence bound falls below the lower bound
+// of the leader. The last moves standing get most of the playouts, and the
+// one with the best win rate is played. Each move keeps its own random
+// number generator across rounds, so the choice still depends only on
+// the seed of the turn. The uniform allocation (the same number of trials
+// for every move) is still available.
 
 // In my evaluations, with 1000 trials per Monte Carlo simulation, the
 // computer takes  about 25  seconds on a  single-core Atom  1.5GHz to
@@ -46,87 +82,205 @@ using namespace std;
 // playing  decisions. On  a  Core i5  2.5GHz,  1000 iterations  takes
 // around 6 seconds, whereas 100 iterations are almost instantaneous.
 
+// random_playout: fills the empty cells of position p, listed in 'cells',
+// in random order (the list is shuffled in place), alternating the colors
+// and starting with 'first'. Returns the winner: once the board is full,
+// exactly one player has connected its walls.
+template <class rng_t>
+Color random_playout(const HexTopology& topo, HexPosition& p,
+                     vector<vertID>& cells, Color first, rng_t& gen) {
+  Color second = (first==Color::BLUE ? Color::RED : Color::BLUE);
+  shuffle(cells.begin(), cells.end(), gen);
+  for(unsigned j=0; j<cells.size(); ++j)
+    p.set_stone(topo, cells[j], ((j%2)==0) ? first : second);
+  return p.is_victory(topo, Color::BLUE) ? Color::BLUE : Color::RED;
+}
+
+// same, on a board of fixed size
+template <unsigned N, class rng_t>
+Color random_playout(FixedHexBoard<N>& b, vector<vertID>& cells,
+                     Color first, rng_t& gen) {
+  Color second = (first==Color::BLUE ? Color::RED : Color::BLUE);
+  shuffle(cells.begin(), cells.end(), gen);
+  for(unsigned j=0; j<cells.size(); ++j)
+    b.set_vertex_key(cells[j], ((j%2)==0) ? first : second);
+  return b.is_victory(Color::BLUE) ? Color::BLUE : Color::RED;
+}
+
+// how the playouts of a turn are spread over the candidate moves
+enum class Allocation {UNIFORM, HALVING};
+
 class AIMonteCarloPlayer: public Player {
 private:
-  // random number generator
+  // what each thread of the pool works with (padded, see CACHE_LINE)
+  struct Worker {
+    vector<vertID> cells; // free positions of a playout
+    char pad[CACHE_LINE];
+  };
+  // what we know about each candidate move during a turn
+  struct Candidate {
+    vertID move;
+    default_random_engine gen; // seeded once per turn
+    unsigned wins, runs;
+    double rate() const { return runs ? double(wins) / runs : 0; }
+  };
+
+  // random number generator (draws the seed of each turn)
   default_random_engine gen;
-  // scratchboard copy of the gameboard
-  HexBoard gcopy;
-  // number of iterations in monte carlo simulations
+  // scratchpad copy of the position of the gameboard (read-only while the
+  // threads simulate)
+  HexPosition scratch;
+  // number of iterations in monte carlo simulations (uniform allocation)
   int trials;
-  // iterate over the list of free vertices and return the number of wins
-  int simulate(vertID curmove, vector<vertID>& others);
+  // total number of playouts per turn (successive halving)
+  unsigned budget;
+  Allocation allocation;
+  // threads that simulate the moves, and their scratch space
+  unique_ptr<ThreadPool> pool;
+  vector<Worker> workers;
+  // plays n random games after curmove and return the number of wins
+  int simulate(vertID curmove, int n, default_random_engine& g, Worker& w);
+  // the playouts of simulate, on a FixedHexBoard<N> or on HexPositions
+  // (called through dispatch_board_size)
+  struct Playouts {
+    AIMonteCarloPlayer& ai;
+    vertID move;
+    int n;
+    default_random_engine& gen;
+    Worker& w;
+
+    template <unsigned N> int run();
+    int run_generic(unsigned dim);
+  };
+  // simulates n more playouts for each of the candidates in 'alive'
+  void run_round(vector<Candidate>& cand, const vector<unsigned>& alive,
+                 unsigned n, unsigned& done, unsigned target);
   // determines if a player won, given that the board is completely full
   bool is_victory(Color sym);
 
 public:
-  AIMonteCarloPlayer(const char* nm, HexBoard *b): 
+  AIMonteCarloPlayer(const char* nm, HexBoard *b,
+                     unsigned threads = default_threads()):
     // initializes the superclass
     Player(nm,b),
     // initializes the random number generator with the current time
     gen(chrono::system_clock::now().time_since_epoch().count()),
-    // create a scratchpad hex board
-    gcopy(b->get_playable_dim()),
-    trials(1000) {}
+    trials(1000), budget(30000), allocation(Allocation::HALVING) {
+    set_threads(threads);
+  }
 
   void play(int& row, int& col);
 
   // sets the number of iterations in monte carlo simulations
   void set_trials(int t) { trials = t; }
+  // sets the total number of playouts of a turn under successive halving
+  void set_budget(unsigned b) { budget = b; }
+  // selects how the playouts are spread over the moves
+  void set_allocation(Allocation a) { allocation = a; }
+  // sets the number of threads that simulate moves (at least one)
+  void set_threads(unsigned n) {
+    pool.reset(new ThreadPool((n > 0) ? n : 1));
+    workers.resize(pool->size());
+  }
+  // reseeds the random number generator (for repeatable games)
+  void set_seed(unsigned s) { gen.seed(s); }
 
-  ~AIMonteCarloPlayer() { gcopy.clear(); }
 };
 
 // Performs  a monte  carlo  simulation for  1  move. Because  integer
 // operations are typically more  efficient and easily comparable than
-// floating-point operations,  I simply return and  compare the number
-// of  successful  outcomes,  rather than  calculating  a  probability
-// (successes/trials).
+// floating-point operations,  I simply return the  number of successful
+// outcomes; the caller keeps track of how many trials each move had.
 
-int AIMonteCarloPlayer::simulate(vertID curmove, vector<vertID>& fvert) {
+int AIMonteCarloPlayer::simulate(vertID curmove, int n,
+                                 default_random_engine& g, Worker& w) {
+  Playouts f = {*this, curmove, n, g, w};
+  return dispatch_board_size(board->get_playable_dim(), f);
+}
+
+template <unsigned N>
+int AIMonteCarloPlayer::Playouts::run() {
   // counter of wins
   int wins = 0;
 
-  // find all elements of fvert that are not curmove
-  vector<vertID> tmp;
-  for(auto p=fvert.begin(); p!=fvert.end(); ++p) {
-    if(*p != curmove)
-      tmp.push_back(*p);
-  }
-
-  // copy over the current board state
-  gcopy.clone_board_state(*board); 
   // determing the symbol of the current playera and opponent
-  Color me = board->get_current_player_symbol();
+  Color me = ai.scratch.get_current_player_symbol();
   Color op = (me==Color::BLUE ? Color::RED : Color::BLUE);
-  // pretend we made a move at curmove
-  gcopy.set_vertex_key(curmove, me);
-
-  // for a specified number of trials
-  for(int i=0; i<trials; ++i) {
-    // shuffle the remaining free positions of the board
-    shuffle (tmp.begin(), tmp.end(), gen);
+  // pretend we made a move at curmove (it may win right away)
+  FixedHexBoard<N> fixed;
+  fixed.set_position(*ai.board->get_hex_topology(), ai.scratch);
+  fixed.set_vertex_key(move, me);
+  if(fixed.is_victory(me))
+    return n;
 
-    // fill the scratchpad graph (alternating the player symbols
-    for(int j=0; j<tmp.size(); ++j)
-      gcopy.set_vertex_key(tmp[j], ((j%2)==0) ? op : me);
+  // the free positions that are not curmove
+  vector<vertID>& tmp = w.cells;
+  fixed.get_free_vertices(tmp);
 
-    // see if 'me' won and update wins if necessary
-    if(gcopy.is_victory(me))
+  // for a specified number of trials
+  for(int i=0; i<n; ++i) {
+    // fill the free positions in random order (the opponent moves next),
+    // see if 'me' won, and empty them again (cheaper than copying the
+    // board, move stack included, for every playout)
+    if(random_playout(fixed, tmp, op, gen) == me)
       wins++;
-
-    // partially undo graph filling (leave curmove)
-    for(auto p=tmp.begin(); p!=tmp.end(); ++p)
-      gcopy.set_vertex_key(*p, Color::WHITE);
+    for(unsigned j=0; j<tmp.size(); ++j)
+      fixed.set_vertex_key(tmp[j], Color::WHITE);
   }
+  return wins;
+}
+
+int AIMonteCarloPlayer::Playouts::run_generic(unsigned) {
+  // counter of wins
+  int wins = 0;
 
-  // undo curmove change
-  gcopy.set_vertex_key(curmove, Color::WHITE);
+  // the size-dependent data (masks and keys) shared with the gameboard
+  const HexTopology& topo = *ai.board->get_hex_topology();
+  // determing the symbol of the current playera and opponent
+  Color me = ai.scratch.get_current_player_symbol();
+  Color op = (me==Color::BLUE ? Color::RED : Color::BLUE);
+  // pretend we made a move at curmove (it may win right away)
+  HexPosition fixed = ai.scratch;
+  fixed.set_stone(topo, move, me);
+  if(fixed.is_victory(topo, me))
+    return n;
+
+  // the free positions that are not curmove, read from the bitboards of
+  // the fixed position
+  vector<vertID>& tmp = w.cells;
+  fixed.get_empty(topo, tmp);
 
-  tmp.clear();
+  // for a specified number of trials
+  for(int i=0; i<n; ++i) {
+    // fill a fresh copy of the fixed position in random order (the
+    // opponent moves next), and see if 'me' won
+    HexPosition pos = fixed;
+    if(random_playout(topo, pos, tmp, op, gen) == me)
+      wins++;
+  }
   return wins;
 }
 
+// Each candidate is simulated by whichever thread takes it, with the
+// generator of the candidate. Shows the thinking progress of the computer
+// (from the calling thread) as the share of the target playouts done.
+void AIMonteCarloPlayer::run_round(vector<Candidate>& cand,
+                                   const vector<unsigned>& alive, unsigned n,
+                                   unsigned& done, unsigned target) {
+  atomic<unsigned> now(done);
+  auto task = [&](unsigned t, size_t i) {
+    Candidate& c = cand[alive[i]];
+    c.wins += simulate(c.move, n, c.gen, workers[t]);
+    c.runs += n;
+    unsigned d = (now += n);
+    if(t == 0)
+      cout << "\r" << name << " thinking..." << (d*100ull/target) << "%   "
+           << flush;
+  };
+  pool->for_each(alive.size(), task);
+  done = now;
+}
+
 // Uses Monte Carlo simulations to determine the next best move.
 void AIMonteCarloPlayer::play(int& row, int& col) {
   // find the list of free vertices (still playable)
@@ -134,34 +288,72 @@ void AIMonteCarloPlayer::play(int& row, int& col) {
   board->get_free_vertices(fvert);
   assert(!fvert.empty());
 
-  // current winner and the highest number of wins so far
-  vertID winner = 0;
-  int hiwins = 0, wins;
-
-  // progress counter
-  int now=0, target=fvert.size();
-
-  // For  each playable  move  (in  fvert) we  perform  a Monte  Carlo
-  // simulation (iterate 1000 times and compute the number of times we
-  // won). Compare the  number of wins to find the  winning move. Show
-  // the  thinking progress  of  the computer,  since  this number  is
-  // deterministic.
-
-  for(auto p=fvert.begin(); p!=fvert.end(); ++p) {
-    now++;
-    cout << "\r" << name << " thinking..." << ((now*100)/target) << "%   ";
-    wins = simulate(*p, fvert);
-    if(wins > hiwins) {
-      hiwins = wins;
-      winner = *p;
+  // copy over the current position (simulate never modifies it)
+  scratch = board->get_position();
+
+  // the seed of this turn (see above), and the candidates, all of them
+  // still in the running
+  unsigned seed = gen();
+  vector<Candidate> cand(fvert.size());
+  vector<unsigned> alive(fvert.size());
+  for(unsigned i=0; i<fvert.size(); ++i) {
+    cand[i].move = fvert[i];
+    cand[i].gen.seed(seed + fvert[i]);
+    cand[i].wins = cand[i].runs = 0;
+    alive[i] = i;
+  }
+
+  unsigned done = 0;
+  if(allocation == Allocation::UNIFORM) {
+    // For  each playable  move  (in  fvert) we  perform  a Monte  Carlo
+    // simulation (iterate 1000 times and compute the number of times we
+    // won)
+    run_round(cand, alive, trials, done, trials * fvert.size());
+  } else {
+    // the number of rounds: ceil(log2(moves)), at least one
+    unsigned rounds = 1;
+    while((1u << rounds) < fvert.size())
+      ++rounds;
+    // the half-width of the confidence interval of a win rate after n
+    // playouts (Hoeffding), wide enough that the best move is dropped by
+    // it in less than one turn out of twenty
+    double spread = log(20.0 * fvert.size() * rounds) / 2;
+
+    unsigned target = max(budget, (unsigned)fvert.size());
+    for(unsigned r=0; r<rounds && alive.size() > 1; ++r) {
+      // an even share of what is left for this and the following rounds
+      unsigned n = (target - min(done, target)) / (alive.size() * (rounds - r));
+      run_round(cand, alive, max(n, 1u), done, target);
+
+      // rank the moves by win rate (the first one, in the order of fvert,
+      // among equals), and keep the better half
+      stable_sort(alive.begin(), alive.end(), [&](unsigned a, unsigned b) {
+        return cand[a].rate() > cand[b].rate();
+      });
+      alive.resize((alive.size() + 1) / 2);
+      // and of those, the ones that might still be better than the leader
+      const Candidate& lead = cand[alive[0]];
+      double low = lead.rate() - sqrt(spread / lead.runs);
+      unsigned keep = 1;
+      while(keep < alive.size()) {
+        const Candidate& c = cand[alive[keep]];
+        if(c.rate() + sqrt(spread / c.runs) < low)
+          break;
+        ++keep;
+      }
+      alive.resize(keep);
     }
-    //cout << "P[" << *p << "] = " << wins  
-    //     << " hiwins:" << hiwins 
-    //     << " winner:" << winner
-    //     << endl;
-    cout << "\r" << name << " thinking..." << ((now*100)/target) << "%   ";
   }
-  cout << endl;
+  cout << "\r" << name << " thinking...100%   " << endl;
+
+  // Compare the win rates to find the winning move (the first one, in the
+  // order of fvert, among those with the best rate)
+  unsigned best = alive[0];
+  for(unsigned i=1; i<alive.size(); ++i)
+    if(cand[alive[i]].rate() > cand[best].rate() ||
+       (cand[alive[i]].rate() == cand[best].rate() && alive[i] < best))
+      best = alive[i];
+  vertID winner = fvert[best];
 
   // return the corresponding row,col coordinates of winner
   assert(winner != 0); // 0 is an invalid playable position
@@ -0,0 +1,201 @@
+// -------------------------------------------------------------------
+// arena.hpp
+//
+// Arena: a region  of memory handed out by bumping a pointer. Freeing
+// memory is  a no-op (except for the most recent allocation, which is
+// simply given back), and the  whole arena is recycled at once with
+// reset(). If a round of allocations outgrows the current block, we chain
+// another one; reset() then merges all blocks into a single one big
+// enough for that round, so after the first round every round lives in
+// one contiguous block and no longer calls the system allocator.
+//
+// ArenaAllocator<T> lets  STL containers allocate from an arena, and the
+// storage policies at the end of this file tell Graph where to keep the
+// edge lists of its vertices (see graph.hpp).
+// author: Luiz Ramos
+
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <vector>
+#include <memory> // unique_ptr, allocator
+#include <cstddef> // size_t
+#include <cstdint> // uintptr_t
+#include <cassert>
+#include <type_traits> // true_type
+using namespace std;
+
+class Arena {
+private:
+  static const size_t MIN_BLOCK = 4096;
+
+  vector<char*> blocks; // blocks in use (the last one is the current)
+  vector<size_t> sizes; // size of each block
+  size_t used; // bytes taken from the current block
+  size_t total; // bytes requested since the last reset (waste included)
+  char* last; // most recent allocation (can be given back)
+
+  Arena(const Arena&); // no copies
+  Arena& operator=(const Arena&);
+
+  void add_block(size_t size) {
+    blocks.push_back(new char[size]);
+    sizes.push_back(size);
+    used = 0;
+  }
+
+  void free_blocks() {
+    for(size_t i=0; i<blocks.size(); ++i)
+      delete[] blocks[i];
+    blocks.clear();
+    sizes.clear();
+  }
+
+public:
+  Arena(): used(0), total(0), last(0) {}
+
+  // returns 'bytes' bytes aligned to 'align' (a power of two)
+  void* allocate(size_t bytes, size_t align) {
+    if(blocks.empty())
+      add_block(MIN_BLOCK);
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(blocks.back());
+    size_t offs = (base + used + align-1) & ~(align-1);
+    offs -= base;
+    if(offs + bytes > sizes.back()) {
+      // doesn't fit: chain a block at least twice as large
+      size_t size = 2 * sizes.back();
+      while(size < bytes + align)
+        size *= 2;
+      add_block(size);
+      base = reinterpret_cast<uintptr_t>(blocks.back());
+      offs = ((base + align-1) & ~(align-1)) - base;
+    }
+
+    total += (offs - used) + bytes;
+    used = offs + bytes;
+    last = blocks.back() + offs;
+    return last;
+  }
+
+  // gives back memory; only the most recent allocation is actually reused
+  void deallocate(void* p, size_t bytes) {
+    if(p == last && p != 0) {
+      used -= bytes;
+      total -= bytes;
+      last = 0;
+    }
+  }
+
+  // recycles all the memory of the arena (everything allocated from it
+  // must be dead by now)
+  void reset() {
+    if(blocks.size() > 1) {
+      // merge: next time, the whole round fits in a single block
+      size_t size = sizes.back();
+      while(size < total)
+        size *= 2;
+      free_blocks();
+      add_block(size);
+    }
+    used = 0;
+    total = 0;
+    last = 0;
+  }
+
+  // number of bytes of all blocks
+  size_t capacity() const {
+    size_t n = 0;
+    for(size_t i=0; i<sizes.size(); ++i)
+      n += sizes[i];
+    return n;
+  }
+
+  ~Arena() { free_blocks(); }
+};
+
+// ArenaAllocator: an STL allocator that takes memory from an Arena. It
+// must be built with the arena (containers keep a copy of it), and two
+// allocators are equal when they share the arena.
+template <class T>
+class ArenaAllocator {
+private:
+  Arena* arena;
+
+  template <class U> friend class ArenaAllocator;
+
+public:
+  typedef T value_type;
+  // containers that are moved or swapped take the arena along
+  typedef true_type propagate_on_container_move_assignment;
+  typedef true_type propagate_on_container_swap;
+
+  ArenaAllocator(Arena* a): arena(a) {}
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U>& o): arena(o.arena) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T* p, size_t n) { arena->deallocate(p, n * sizeof(T)); }
+
+  template <class U>
+  bool operator==(const ArenaAllocator<U>& o) const { return arena == o.arena; }
+  template <class U>
+  bool operator!=(const ArenaAllocator<U>& o) const { return arena != o.arena; }
+};
+
+// Storage policies:  where Graph keeps the edge lists of its vertices,
+// given as its last template parameter. A policy provides the allocator
+// type for a given element type, an allocator object, and release(),
+// which Graph calls from clear() once all edge lists are gone.
+//
+// HeapStorage: every edge list is a separate heap allocation (the
+// default).
+// ArenaStorage: all edge lists share an Arena owned by the graph, which
+// is recycled by clear(), so rebuilding a graph of the same size (like
+// HexBoard::reset_board does for every game) allocates nothing. Copies of
+// the graph get their own arena.
+
+struct HeapStorage {
+  template <class T>
+  struct rebind { typedef allocator<T> other; };
+
+  template <class T>
+  allocator<T> get_allocator() { return allocator<T>(); }
+
+  void release() {}
+};
+
+class ArenaStorage {
+private:
+  unique_ptr<Arena> arena; // on the heap, so moves keep its address
+
+  Arena* get_arena() {
+    if(!arena) // moved-from storage
+      arena.reset(new Arena());
+    return arena.get();
+  }
+
+public:
+  template <class T>
+  struct rebind { typedef ArenaAllocator<T> other; };
+
+  ArenaStorage() {}
+  ArenaStorage(const ArenaStorage&) {}
+  ArenaStorage& operator=(const ArenaStorage&) { return *this; }
+  ArenaStorage(ArenaStorage&& o) noexcept: arena(move(o.arena)) {}
+  ArenaStorage& operator=(ArenaStorage&& o) noexcept {
+    arena = move(o.arena);
+    return *this;
+  }
+
+  template <class T>
+  ArenaAllocator<T> get_allocator() { return ArenaAllocator<T>(get_arena()); }
+
+  void release() {
+    if(arena)
+      arena->reset();
+  }
+};
+#endif
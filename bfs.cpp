@@ -0,0 +1,129 @@
+//--------------------------------------------------------------------
+// Parallel BFS benchmark
+// author: Luiz Ramos
+
+// Builds a large random graph, freezes it into a CSRGraph and runs the
+// direction-optimizing ParallelBFS with 1, 2, 4, ... threads (up to the
+// number of cores, or the given maximum), reporting the time, the
+// throughput in millions of traversed edges per second (MTEPS) and the
+// speedup over one thread. Every run is checked against the sequential
+// bfs of graph.hpp.
+//
+// usage: pbfs [nodes] [edges] [max threads] [seed]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib> // atoi
+#include <chrono>
+#include <thread>
+#include "graph.hpp"
+#include "csrgraph.hpp"
+#include "generator.hpp"
+#include "parallelbfs.hpp"
+using namespace std;
+
+typedef Graph<vertID,double> WGraph;
+typedef CSRGraph<vertID,double> WCSRGraph;
+
+// records the level of every vertex found by the sequential search
+struct LevelVisitor {
+  vector<unsigned>& level;
+  vertID cur; // vertex being expanded
+
+  LevelVisitor(vector<unsigned>& l): level(l), cur(NO_VERTEX) {}
+  bool follow(vertID from, vertID) {
+    cur = from;
+    return true;
+  }
+  bool discover(vertID v) {
+    level[v] = (cur == NO_VERTEX) ? 0 : level[cur]+1;
+    return false;
+  }
+};
+
+double elapsed(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// runs the search a few times and returns the best time
+template <class graph_t>
+double time_bfs(graph_t& g, ParallelBFS& bfs, vertID src, unsigned reps) {
+  double best = 0;
+  for(unsigned r=0; r<reps; ++r) {
+    chrono::steady_clock::time_point t = chrono::steady_clock::now();
+    bfs.run(g, src);
+    double secs = elapsed(t);
+    if(r == 0 || secs < best)
+      best = secs;
+  }
+  return best;
+}
+
+// compares the levels of the parallel search with the reference
+bool check(ParallelBFS& bfs, vector<unsigned>& ref) {
+  for(vertID v=0; v<ref.size(); ++v)
+    if(bfs.get_level(v) != ref[v])
+      return false;
+  return true;
+}
+
+int main(int argc, char** argv) {
+  unsigned nodes = (argc > 1) ? atoi(argv[1]) : 1000000;
+  unsigned edges = (argc > 2) ? atoi(argv[2]) : 8*nodes;
+  unsigned maxthreads = (argc > 3) ? atoi(argv[3]) : thread::hardware_concurrency();
+  unsigned seed = (argc > 4) ? atoi(argv[4]) : 1;
+  const unsigned REPS = 3;
+  if(maxthreads == 0)
+    maxthreads = 1;
+
+  cout << "Random graph: " << nodes << " nodes, " << edges << " edges, seed "
+       << seed << endl;
+  WGraph g;
+  random_graph(g, nodes, edges, 1.0, 100.0, seed);
+  WCSRGraph csr(g);
+
+  // reference levels (unreached vertices keep UNREACHED)
+  vector<unsigned> ref(nodes, static_cast<unsigned>(ParallelBFS::UNREACHED));
+  TraversalWorkspace ws;
+  LevelVisitor vis(ref);
+  chrono::steady_clock::time_point t = chrono::steady_clock::now();
+  bfs(csr, 0, ws, vis);
+  double base = elapsed(t);
+
+  // traversed edges per second, counting every edge of the graph once
+  double teps = static_cast<double>(edges);
+  ParallelBFS pbfs(1);
+
+  cout << fixed << setprecision(3)
+       << "sequential bfs     " << setw(8) << base << " s " << setw(9)
+       << setprecision(1) << teps / base / 1e6 << " MTEPS" << endl;
+
+  double one = 0;
+  for(unsigned n=1; ; n *= 2) {
+    if(n > maxthreads)
+      n = maxthreads;
+    pbfs.set_threads(n);
+    double secs = time_bfs(csr, pbfs, 0, REPS);
+    if(n == 1)
+      one = secs;
+
+    cout << "parallel bfs x" << setw(3) << left << n << right << " "
+         << setprecision(3) << setw(8) << secs << " s " << setw(9)
+         << setprecision(1) << teps / secs / 1e6 << " MTEPS, speedup "
+         << setprecision(2) << one / secs
+         << " (" << pbfs.get_top_down_steps() << " top-down, "
+         << pbfs.get_bottom_up_steps() << " bottom-up)"
+         << (check(pbfs, ref) ? "" : " MISMATCH") << endl;
+    if(n == maxthreads)
+      break;
+  }
+
+  // the same search straight on the Graph ADT
+  pbfs.set_threads(maxthreads);
+  double secs = time_bfs(g, pbfs, 0, REPS);
+  cout << "parallel bfs x" << setw(3) << left << maxthreads << right
+       << " (Graph) " << setprecision(3) << secs << " s"
+       << (check(pbfs, ref) ? "" : " MISMATCH") << endl;
+  cout << pbfs.get_reached() << " vertices reached" << endl;
+  return 0;
+}
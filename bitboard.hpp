@@ -0,0 +1,268 @@
+// -------------------------------------------------------------------
+// bitboard.hpp
+//
+// BitBoard: a packed representation  of the stones on a Hex board. We
+// keep one bitset  per player, where bit i  corresponds to the vertex
+// with ID i  of the HexBoard graph (margins  included). Margin vertices
+// are never set, so they act as  guards: shifting a row of stones left
+// or right lands on a margin bit and is masked away. This allows us to
+// decide victory  with a bit-parallel  flood fill (a handful  of shifts
+// and masks per step), instead of  a DFS over the graph that allocates
+// memory and chases pointers.
+// author: Luiz Ramos
+
+#ifndef BITBOARD_HPP
+#define BITBOARD_HPP
+
+#include <cstdint> // uint64_t
+#include <cassert> // assert
+#include <vector>
+#include "graph.hpp"
+using namespace std;
+
+// the largest playable dimension supported by the bitboard (19x19, which
+// turns into 21x21 vertices once we add the margins)
+const unsigned BB_MAX_DIM = 19;
+const unsigned BB_MAX_CELLS = (BB_MAX_DIM+2) * (BB_MAX_DIM+2);
+const unsigned BB_WORDS = (BB_MAX_CELLS+63) / 64;
+
+// appends to out the index of every bit set in words[0..n), in increasing
+// order: the output is sized once with popcounts, and then each bit costs
+// one count-trailing-zeros (no per-cell tests)
+inline void append_bits(const uint64_t* words, unsigned n,
+                        vector<vertID>& out) {
+  size_t total = out.size();
+  for(unsigned i=0; i<n; ++i)
+    total += __builtin_popcountll(words[i]);
+  size_t first = out.size();
+  out.resize(total);
+
+  vertID* p = out.data() + first;
+  for(unsigned i=0; i<n; ++i)
+    for(uint64_t x = words[i]; x; x &= x-1)
+      *p++ = i*64 + __builtin_ctzll(x);
+}
+
+// BitSet: fixed-size  set of bits  stored in 64-bit  words. Unlike
+// std::bitset, it  is a plain array  of words we can  shift by small
+// amounts cheaply and copy with memcpy.
+struct BitSet {
+  uint64_t w[BB_WORDS];
+
+  BitSet() { clear(); }
+
+  void clear() {
+    for(unsigned i=0; i<BB_WORDS; ++i) w[i] = 0;
+  }
+
+  void set(vertID i) { w[i>>6] |= (static_cast<uint64_t>(1) << (i&63)); }
+  void reset(vertID i) { w[i>>6] &= ~(static_cast<uint64_t>(1) << (i&63)); }
+  bool test(vertID i) const { return (w[i>>6] >> (i&63)) & 1; }
+
+  // returns n (< 64) consecutive bits starting at bit 'first', as the
+  // lowest bits of a word
+  uint64_t extract(vertID first, unsigned n) const {
+    unsigned i = first >> 6, k = first & 63;
+    uint64_t bits = w[i] >> k;
+    if(k+n > 64 && i+1 < BB_WORDS)
+      bits |= w[i+1] << (64-k);
+    return bits & ((static_cast<uint64_t>(1) << n) - 1);
+  }
+
+  bool none() const {
+    uint64_t acc = 0;
+    for(unsigned i=0; i<BB_WORDS; ++i) acc |= w[i];
+    return acc == 0;
+  }
+
+  // number of bits set
+  unsigned count() const {
+    unsigned n = 0;
+    for(unsigned i=0; i<BB_WORDS; ++i) n += __builtin_popcountll(w[i]);
+    return n;
+  }
+
+  // appends the index of every bit set to out, in increasing order
+  void get_bits(vector<vertID>& out) const { append_bits(w, BB_WORDS, out); }
+
+  // true if this set and 'o' have at least one bit in common
+  bool intersects(const BitSet& o) const {
+    uint64_t acc = 0;
+    for(unsigned i=0; i<BB_WORDS; ++i) acc |= (w[i] & o.w[i]);
+    return acc != 0;
+  }
+
+  // shifts towards higher vertex IDs by k bits (0 < k < 64)
+  BitSet shl(unsigned k) const {
+    BitSet r;
+    r.w[0] = w[0] << k;
+    for(unsigned i=1; i<BB_WORDS; ++i)
+      r.w[i] = (w[i] << k) | (w[i-1] >> (64-k));
+    return r;
+  }
+
+  // shifts towards lower vertex IDs by k bits (0 < k < 64)
+  BitSet shr(unsigned k) const {
+    BitSet r;
+    for(unsigned i=0; i<BB_WORDS-1; ++i)
+      r.w[i] = (w[i] >> k) | (w[i+1] << (64-k));
+    r.w[BB_WORDS-1] = w[BB_WORDS-1] >> k;
+    return r;
+  }
+
+  BitSet operator|(const BitSet& o) const {
+    BitSet r;
+    for(unsigned i=0; i<BB_WORDS; ++i) r.w[i] = w[i] | o.w[i];
+    return r;
+  }
+
+  BitSet operator&(const BitSet& o) const {
+    BitSet r;
+    for(unsigned i=0; i<BB_WORDS; ++i) r.w[i] = w[i] & o.w[i];
+    return r;
+  }
+
+  // bits of this set that are not in 'o'
+  BitSet operator-(const BitSet& o) const {
+    BitSet r;
+    for(unsigned i=0; i<BB_WORDS; ++i) r.w[i] = w[i] & ~o.w[i];
+    return r;
+  }
+
+  bool operator==(const BitSet& o) const {
+    for(unsigned i=0; i<BB_WORDS; ++i)
+      if(w[i] != o.w[i]) return false;
+    return true;
+  }
+
+  bool operator!=(const BitSet& o) const { return !(*this == o); }
+};
+
+// BitBoard: the stones of both players.  Players are addressed by
+// index: 0 is the player that connects the left and right walls (BLUE
+// in the HexBoard) and 1 is the  player that connects the top and bottom
+// walls (RED). A BitBoard is a plain value (two arrays of words), so it
+// can be copied with memcpy.
+class BitBoard {
+private:
+  BitSet stones[2]; // stones of each player
+
+public:
+  // removes all stones
+  void clear() {
+    stones[0].clear();
+    stones[1].clear();
+  }
+
+  // places a stone of 'player' on (playable) vertex v
+  void set(vertID v, int player) {
+    stones[1-player].reset(v);
+    stones[player].set(v);
+  }
+
+  // removes any stone from vertex v
+  void clear(vertID v) {
+    stones[0].reset(v);
+    stones[1].reset(v);
+  }
+
+  // returns the player with a stone on v, or -1 if v is empty
+  int owner(vertID v) const {
+    if(stones[0].test(v)) return 0;
+    if(stones[1].test(v)) return 1;
+    return -1;
+  }
+
+  const BitSet& get_stones(int player) const { return stones[player]; }
+
+  // cells of 'area' without a stone
+  BitSet get_empty(const BitSet& area) const {
+    return area - (stones[0] | stones[1]);
+  }
+
+  bool operator==(const BitBoard& o) const {
+    return stones[0] == o.stones[0] && stones[1] == o.stones[1];
+  }
+};
+
+// BitMasks: the masks that describe the geometry of a board of a given
+// dimension, and the victory test for a BitBoard of that dimension.
+class BitMasks {
+private:
+  // distance (in bits) between two consecutive rows: rel_dim+2
+  vertID stride;
+  // playable vertices (the board without margins)
+  BitSet playable;
+  // cells next to the first/last wall of each player
+  BitSet src[2], dst[2];
+
+  // grows 'x' by one step  in every hex direction.  In  a row-major
+  // layout, the neighbors of (r,c) are (r,c-1), (r,c+1), (r-1,c),
+  // (r-1,c+1), (r+1,c-1) and (r+1,c), so the row above takes x and
+  // x shifted right by one column and the row below takes x and x
+  // shifted left by one column.
+  BitSet grow(const BitSet& x) const {
+    BitSet l = x.shl(1), r = x.shr(1);
+    return l | r | (x | l).shr(stride) | (x | r).shl(stride);
+  }
+
+public:
+  BitMasks(): stride(0) {}
+
+  // prepares the masks of a board of dim x dim playable positions
+  void reset(vertID dim) {
+    assert(dim <= BB_MAX_DIM);
+    stride = dim+2;
+    playable.clear();
+    for(unsigned p=0; p<2; ++p) {
+      src[p].clear();
+      dst[p].clear();
+    }
+
+    for(vertID row=1; row<=dim; ++row) {
+      for(vertID col=1; col<=dim; ++col)
+        playable.set(row*stride + col);
+
+      // player 0 goes from the left wall to the right wall
+      src[0].set(row*stride + 1);
+      dst[0].set(row*stride + dim);
+      // player 1 goes from the top wall to the bottom wall
+      src[1].set(stride + row);
+      dst[1].set(dim*stride + row);
+    }
+  }
+
+  // verifies if vertex v is part of the playable area
+  bool is_playable(vertID v) const { return playable.test(v); }
+  const BitSet& get_playable() const { return playable; }
+
+  // playable vertices without a stone, and how many there are
+  BitSet get_empty(const BitBoard& b) const { return b.get_empty(playable); }
+  unsigned count_empty(const BitBoard& b) const {
+    return get_empty(b).count();
+  }
+
+  // Bit-parallel flood fill: starting from the stones that touch the
+  // first wall, keep adding neighboring stones of the same player until
+  // we either touch the opposite wall or stop growing.
+  bool is_victory(const BitBoard& b, int player) const {
+    return is_victory(b.get_stones(player), player);
+  }
+
+  // same, for the stones of 'player' given as a bitset (no margin bits)
+  bool is_victory(const BitSet& mine, int player) const {
+    BitSet reach = mine & src[player];
+
+    while(!reach.none()) {
+      if(reach.intersects(dst[player]))
+        return true;
+
+      BitSet next = (reach | grow(reach)) & mine;
+      if(next == reach)
+        break;
+      reach = next;
+    }
+    return false;
+  }
+};
+#endif
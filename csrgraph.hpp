@@ -0,0 +1,143 @@
+// -------------------------------------------------------------------
+// csrgraph.hpp
+//
+// CSRGraph: an immutable version of Graph in compressed sparse row
+// form.  Instead of one  edge vector per vertex, all  adjacencies live
+// in three  contiguous arrays: offsets[v]..offsets[v+1]  delimits the
+// neighbors  of v  in  targets,  and weights  holds  the matching edge
+// values.  A CSRGraph is built  from a Graph in O(V+E) and hands out
+// neighbor ranges that point  straight into its arrays (no copies).
+// Vertex keys may  still be modified; only the  topology is frozen.
+// author: Luiz Ramos
+
+#ifndef CSRGRAPH_HPP
+#define CSRGRAPH_HPP
+
+#include <vector>
+#include <cassert>
+#include "graph.hpp"
+using namespace std;
+
+// ArrayRange: a read-only view of consecutive elements of an array, usable
+// in range-based for loops.
+template <class T>
+struct ArrayRange {
+  const T *first, *last;
+
+  ArrayRange(const T* first, const T* last): first(first), last(last) {}
+  const T* begin() const { return first; }
+  const T* end() const { return last; }
+  unsigned size() const { return static_cast<unsigned>(last - first); }
+  const T& operator[](unsigned i) const { return first[i]; }
+};
+
+template <class vtype, class etype>
+class CSRGraph {
+private:
+  vector<vtype> keys; // value of each vertex
+  vector<unsigned> offsets; // first adjacency of each vertex (plus sentinel)
+  vector<vertID> targets; // neighbor IDs, grouped by vertex
+  vector<etype> weights; // edge values, parallel to targets
+
+  // position of the edge (x,y) in targets, or -1 if not found
+  int find(vertID x, vertID y) const {
+    for(unsigned i=offsets[x]; i<offsets[x+1]; ++i)
+      if(targets[i] == y)
+        return static_cast<int>(i);
+    return -1;
+  }
+
+public:
+  CSRGraph() { offsets.push_back(0); }
+  template <class index, class storage, class idtype>
+  CSRGraph(Graph<vtype,etype,index,storage,idtype>& g) { build(g); }
+
+  // freezes graph g: one pass to compute the offsets, one pass to copy
+  // the adjacencies
+  template <class index, class storage, class idtype>
+  void build(Graph<vtype,etype,index,storage,idtype>& g) {
+    unsigned n = g.get_nodes();
+    keys.resize(n);
+    offsets.resize(n+1);
+
+    offsets[0] = 0;
+    for(vertID v=0; v<n; ++v) {
+      keys[v] = g.get_vertex_key(v);
+      offsets[v+1] = offsets[v] + g.get_degree(v);
+    }
+
+    targets.resize(offsets[n]);
+    weights.resize(offsets[n]);
+    for(vertID v=0; v<n; ++v) {
+      unsigned base = offsets[v];
+      for(unsigned i=0; i<g.get_degree(v); ++i) {
+        targets[base+i] = g.get_neighbor(v, i);
+        weights[base+i] = g.get_neighbor_weight(v, i);
+      }
+    }
+  }
+
+  // acessor methods
+  unsigned get_nodes() const { return keys.size(); }
+  // each undirected edge is stored twice (once per endpoint)
+  unsigned get_edges() const { return targets.size() / 2; }
+  unsigned get_degree(vertID v) const { return offsets[v+1] - offsets[v]; }
+  vertID get_neighbor(vertID v, unsigned i) const {
+    return targets[offsets[v]+i];
+  }
+  etype get_neighbor_weight(vertID v, unsigned i) const {
+    return weights[offsets[v]+i];
+  }
+
+  // calls f(w) for every neighbor w of v (see the traversals in graph.hpp)
+  template <class F>
+  void for_each_neighbor(vertID v, F& f) const {
+    for(unsigned i=offsets[v]; i<offsets[v+1]; ++i)
+      f(targets[i]);
+  }
+
+  bool is_vertex(vertID x) const { return x < get_nodes(); }
+
+  // neighbors of v, as a view into the targets array
+  ArrayRange<vertID> neighbors(vertID v) const {
+    assert(is_vertex(v));
+    return ArrayRange<vertID>(targets.data() + offsets[v],
+                              targets.data() + offsets[v+1]);
+  }
+
+  // edge values of v, in the same order as neighbors(v)
+  ArrayRange<etype> neighbor_weights(vertID v) const {
+    assert(is_vertex(v));
+    return ArrayRange<etype>(weights.data() + offsets[v],
+                             weights.data() + offsets[v+1]);
+  }
+
+  // raw arrays, for algorithms that prefer indices over ranges
+  const unsigned* get_offsets() const { return offsets.data(); }
+  const vertID* get_targets() const { return targets.data(); }
+  const etype* get_weights() const { return weights.data(); }
+
+  // verifies if there is an edge between x and y
+  bool is_adjacent(vertID x, vertID y) const {
+    assert(is_vertex(x) && is_vertex(y));
+    return find(x, y) >= 0;
+  }
+
+  // returns the weight of the edge between x and y (the edge must exist)
+  etype get_edge_weight(vertID x, vertID y) const {
+    int i = find(x, y);
+    assert(i >= 0);
+    return weights[i];
+  }
+
+  vtype get_vertex_key(vertID x) const {
+    assert(is_vertex(x));
+    return keys[x];
+  }
+
+  void set_vertex_key(vertID x, vtype key) {
+    assert(is_vertex(x));
+    keys[x] = key;
+  }
+};
+#endif
@@ -0,0 +1,90 @@
+// -------------------------------------------------------------------
+// dijkstra.hpp
+//
+// Single-source shortest paths on graphs with non-negative weights. We
+// keep the tentative distances in a DaryHeap with decrease-key, so every
+// vertex enters the queue once and the run costs O(E log_D V). All the
+// memory (distances, parents, heap) lives in a ShortestPaths object that
+// the caller keeps between runs: once its arrays have grown to the size
+// of the graph, later searches don't allocate.
+//
+// The graph can be a Graph (any index policy) or a CSRGraph: we only need
+// get_nodes(), get_degree(v), get_neighbor(v,i) and
+// get_neighbor_weight(v,i). The weight type must be a number.
+// author: Luiz Ramos
+
+#ifndef DIJKSTRA_HPP
+#define DIJKSTRA_HPP
+
+#include <vector>
+#include <limits>
+#include <algorithm> // reverse
+#include <cassert>
+#include "graph.hpp"
+#include "priorityqueue.hpp"
+using namespace std;
+
+template <class etype>
+class ShortestPaths {
+private:
+  vector<etype> dist; // distance from the source
+  vector<vertID> parent; // previous vertex in a shortest path
+  DaryHeap<etype> queue; // vertices whose distance is still tentative
+  vertID source;
+
+  template <class graph_t, class wtype>
+  friend void dijkstra(graph_t& g, vertID src, ShortestPaths<wtype>& sp);
+
+public:
+  ShortestPaths(): source(NO_VERTEX) {}
+
+  // distance of unreachable vertices
+  static etype infinity() { return numeric_limits<etype>::max(); }
+
+  vertID get_source() const { return source; }
+  etype get_distance(vertID v) const { return dist[v]; }
+  vertID get_parent(vertID v) const { return parent[v]; }
+  bool is_reachable(vertID v) const { return dist[v] != infinity(); }
+
+  // fills 'path' with the vertices from the source to v (empty if v can't
+  // be reached)
+  void get_path(vertID v, vector<vertID>& path) const {
+    path.clear();
+    if(!is_reachable(v))
+      return;
+    for(; v != NO_VERTEX; v = parent[v])
+      path.push_back(v);
+    reverse(path.begin(), path.end());
+  }
+};
+
+// computes the distance from src to every vertex of g into sp
+template <class graph_t, class etype>
+void dijkstra(graph_t& g, vertID src, ShortestPaths<etype>& sp) {
+  unsigned n = g.get_nodes();
+  assert(src < n);
+  sp.dist.assign(n, ShortestPaths<etype>::infinity());
+  sp.parent.assign(n, NO_VERTEX);
+  sp.queue.reset(n);
+  sp.source = src;
+
+  sp.dist[src] = etype();
+  sp.queue.push(src, etype());
+  while(!sp.queue.empty()) {
+    vertID v = sp.queue.pop(); // dist[v] is final
+    etype dv = sp.dist[v];
+
+    unsigned degree = g.get_degree(v);
+    for(unsigned i=0; i<degree; ++i) {
+      vertID w = g.get_neighbor(v, i);
+      etype dw = dv + g.get_neighbor_weight(v, i);
+      assert(!(g.get_neighbor_weight(v, i) < etype())); // no negative weights
+      if(dw < sp.dist[w]) {
+        sp.dist[w] = dw;
+        sp.parent[w] = v;
+        sp.queue.push(w, dw);
+      }
+    }
+  }
+}
+#endif
@@ -0,0 +1,130 @@
+// -------------------------------------------------------------------
+// disjointset.hpp
+//
+// Disjoint-set (union-find) structures over vertex IDs. Two variants:
+// DisjointSets uses union by rank and path compression, so each find
+// runs  in nearly constant amortized  time; RollbackDisjointSets uses
+// union by size  without path compression, which keeps  every union a
+// single pointer  change that  can be recorded  and undone  later (at
+// the cost of O(log n) finds).
+// author: Luiz Ramos
+
+#ifndef DISJOINTSET_HPP
+#define DISJOINTSET_HPP
+
+#include <vector>
+#include <cassert>
+#include "graph.hpp"
+using namespace std;
+
+class DisjointSets {
+private:
+  vector<vertID> parent; // parent of each element (roots point to self)
+  vector<unsigned char> rank; // upper bound of the height of each tree
+
+public:
+  DisjointSets() {}
+  DisjointSets(unsigned n) { reset(n); }
+
+  // makes n singleton sets {0}, {1}, ..., {n-1}
+  void reset(unsigned n) {
+    parent.resize(n);
+    rank.assign(n, 0);
+    for(vertID i=0; i<n; ++i)
+      parent[i] = i;
+  }
+
+  unsigned size() { return parent.size(); }
+
+  // returns the representative of x, halving the path along the way
+  vertID find(vertID x) {
+    assert(x < parent.size());
+    while(parent[x] != x) {
+      parent[x] = parent[parent[x]];
+      x = parent[x];
+    }
+    return x;
+  }
+
+  // merges the sets of x and y; returns false if they were already merged
+  bool unite(vertID x, vertID y) {
+    x = find(x);
+    y = find(y);
+    if(x == y)
+      return false;
+
+    if(rank[x] < rank[y])
+      swap(x, y);
+    parent[y] = x;
+    if(rank[x] == rank[y])
+      rank[x]++;
+    return true;
+  }
+
+  // verifies if x and y belong to the same set
+  bool same(vertID x, vertID y) { return find(x) == find(y); }
+};
+
+class RollbackDisjointSets {
+private:
+  vector<vertID> parent; // parent of each element (roots point to self)
+  vector<unsigned> weight; // number of elements under each root
+  vector<vertID> history; // roots that were attached to another root
+
+public:
+  RollbackDisjointSets() {}
+  RollbackDisjointSets(unsigned n) { reset(n); }
+
+  // makes n singleton sets and forgets the history of unions
+  void reset(unsigned n) {
+    parent.resize(n);
+    weight.assign(n, 1);
+    history.clear();
+    for(vertID i=0; i<n; ++i)
+      parent[i] = i;
+  }
+
+  unsigned size() { return parent.size(); }
+
+  // returns the representative of x (no path compression, so that the
+  // trees only change in unite)
+  vertID find(vertID x) {
+    assert(x < parent.size());
+    while(parent[x] != x)
+      x = parent[x];
+    return x;
+  }
+
+  // merges the sets of x and y; returns false if they were already merged
+  bool unite(vertID x, vertID y) {
+    x = find(x);
+    y = find(y);
+    if(x == y)
+      return false;
+
+    if(weight[x] < weight[y])
+      swap(x, y);
+    parent[y] = x;
+    weight[x] += weight[y];
+    history.push_back(y);
+    return true;
+  }
+
+  // verifies if x and y belong to the same set
+  bool same(vertID x, vertID y) { return find(x) == find(y); }
+
+  // returns a checkpoint that can be passed to rollback
+  size_t mark() { return history.size(); }
+
+  // undoes every union performed after checkpoint m (most recent first)
+  void rollback(size_t m) {
+    assert(m <= history.size());
+    while(history.size() > m) {
+      vertID y = history.back();
+      history.pop_back();
+      weight[parent[y]] -= weight[y];
+      parent[y] = y;
+    }
+  }
+};
+#endif
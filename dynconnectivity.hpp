@@ -0,0 +1,515 @@
+// -------------------------------------------------------------------
+// dynconnectivity.hpp
+//
+// DynamicConnectivity: answers "are u and v connected?" while edges are
+// inserted and deleted, without traversing the graph. We use the
+// algorithm of Holm, de Lichtenberg and Thorup (HDT): O(log^2 n)
+// amortized per update and O(log n) per query.
+//
+// Every edge has a level in 0..L-1 (L = log2(n)+1), which only goes up.
+// F_i is a spanning forest of the edges of level >= i, so F_0 is a
+// spanning forest of the whole graph and F_0 ⊇ F_1 ⊇ ... ⊇ F_{L-1}. Each
+// tree of F_i has at most n/2^i vertices. Edges in some F_i are tree
+// edges; the others are non-tree edges.
+//
+// Inserting an edge either links two trees of F_0 or adds a non-tree edge.
+// Deleting a non-tree edge is trivial. Deleting a tree edge of level l
+// cuts it from F_0..F_l and looks for a replacement, from level l down to
+// 0: in the smaller of the two halves of F_i, we first raise every tree
+// edge of level i (the half is small enough to live at level i+1), then
+// scan its non-tree edges of level i. An edge that leaves the half
+// reconnects it and becomes a tree edge; an edge that doesn't is raised to
+// level i+1, which pays for having looked at it.
+//
+// Each forest is stored as Euler tours kept in treaps (EulerTourForest),
+// so linking, cutting and finding the tree of a vertex take O(log n). The
+// treap nodes keep two marks, summarized over their subtrees, so that the
+// search above can find the next tree edge of level i (arcs) and the next
+// vertex with non-tree edges of level i in O(log n).
+//
+// ConnectivityGraph is a Graph that keeps a DynamicConnectivity in sync
+// with its add_edge/del_edge, and answers is_connected.
+// author: Luiz Ramos
+
+#ifndef DYNCONNECTIVITY_HPP
+#define DYNCONNECTIVITY_HPP
+
+#include <vector>
+#include <deque>
+#include <memory> // unique_ptr
+#include <unordered_map>
+#include <cstdint> // uint32_t, uint64_t
+#include <cassert>
+#include "graph.hpp"
+using namespace std;
+
+// EttNode: an element of an Euler tour: the occurrence of a vertex
+// (a == b) or the traversal of a tree edge from a to b (an arc)
+struct EttNode {
+  EttNode *left, *right, *parent; // treap links
+  uint32_t prio; // heap order of the treap
+  unsigned size; // nodes in this subtree
+  unsigned vertices; // vertex occurrences in this subtree
+  vertID a, b;
+  bool is_vertex;
+  // marks: tree arc of the level of the forest, vertex with non-tree edges
+  // of that level; any_* summarize the subtree
+  bool arc_mark, vertex_mark, any_arc, any_vertex;
+
+  void init(vertID from, vertID to, bool vertex, uint32_t p) {
+    left = right = parent = 0;
+    prio = p;
+    a = from;
+    b = to;
+    is_vertex = vertex;
+    arc_mark = vertex_mark = false;
+    update();
+  }
+
+  // recomputes the summaries from the children
+  void update() {
+    size = 1;
+    vertices = is_vertex ? 1 : 0;
+    any_arc = arc_mark;
+    any_vertex = vertex_mark;
+    if(left) {
+      size += left->size;
+      vertices += left->vertices;
+      any_arc |= left->any_arc;
+      any_vertex |= left->any_vertex;
+    }
+    if(right) {
+      size += right->size;
+      vertices += right->vertices;
+      any_arc |= right->any_arc;
+      any_vertex |= right->any_vertex;
+    }
+  }
+};
+
+// EulerTourForest: a forest over vertices 0..n-1, each tree stored as the
+// (circular) sequence of its Euler tour in a treap. A tree with vertex
+// set S has |S| vertex nodes and two arcs per edge; the root of its treap
+// identifies the tree.
+class EulerTourForest {
+private:
+  vector<EttNode> vert; // occurrence of each vertex (never moves)
+  uint64_t seed; // for the priorities
+
+  uint32_t random() {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return static_cast<uint32_t>(seed);
+  }
+
+  static unsigned size(EttNode* t) { return t ? t->size : 0; }
+
+  // concatenates the sequences of treaps a and b
+  static EttNode* merge(EttNode* a, EttNode* b) {
+    if(!a) return b;
+    if(!b) return a;
+    if(a->prio > b->prio) {
+      a->right = merge(a->right, b);
+      a->right->parent = a;
+      a->update();
+      return a;
+    }
+    b->left = merge(a, b->left);
+    b->left->parent = b;
+    b->update();
+    return b;
+  }
+
+  // splits treap t into its first k nodes (l) and the rest (r)
+  static void split(EttNode* t, unsigned k, EttNode*& l, EttNode*& r) {
+    if(!t) {
+      l = r = 0;
+      return;
+    }
+    t->parent = 0;
+    if(size(t->left) < k) {
+      split(t->right, k - size(t->left) - 1, t->right, r);
+      if(t->right) t->right->parent = t;
+      l = t;
+    } else {
+      split(t->left, k, l, t->left);
+      if(t->left) t->left->parent = t;
+      r = t;
+    }
+    t->update();
+  }
+
+  // position of x in its sequence
+  static unsigned index(EttNode* x) {
+    unsigned i = size(x->left);
+    for(; x->parent; x = x->parent)
+      if(x == x->parent->right)
+        i += size(x->parent->left) + 1;
+    return i;
+  }
+
+  // rotates the tour of v's tree so that it starts at v
+  void reroot(vertID v) {
+    EttNode* x = &vert[v];
+    EttNode *l, *r;
+    split(find_root(x), index(x), l, r);
+    merge(r, l);
+  }
+
+public:
+  EulerTourForest(): seed(0x2545f4914f6cdd1dULL) {}
+
+  // n isolated vertices
+  void reset(unsigned n) {
+    vert.resize(n);
+    for(vertID v=0; v<n; ++v)
+      vert[v].init(v, v, true, random());
+  }
+
+  EttNode* get_vertex(vertID v) { return &vert[v]; }
+
+  static EttNode* find_root(EttNode* x) {
+    while(x->parent)
+      x = x->parent;
+    return x;
+  }
+
+  bool connected(vertID u, vertID v) {
+    return find_root(&vert[u]) == find_root(&vert[v]);
+  }
+
+  // number of vertices of the tree of v
+  unsigned tree_size(vertID v) { return find_root(&vert[v])->vertices; }
+
+  // joins the trees of u and v with edge (u,v), using the arc nodes uv and
+  // vu (u and v must be in different trees)
+  void link(vertID u, vertID v, EttNode* uv, EttNode* vu) {
+    uv->init(u, v, false, random());
+    vu->init(v, u, false, random());
+    reroot(u);
+    reroot(v);
+    EttNode* tu = find_root(&vert[u]);
+    EttNode* tv = find_root(&vert[v]);
+    merge(merge(merge(tu, uv), tv), vu);
+  }
+
+  // removes the edge with arc nodes uv and vu, splitting its tree
+  void cut(EttNode* uv, EttNode* vu) {
+    unsigned i = index(uv), j = index(vu);
+    if(i > j) {
+      swap(i, j);
+      swap(uv, vu);
+    }
+    // tour = A uv B vu C: B is one side, C+A the other
+    EttNode *a, *rest, *mid, *c, *first, *inner, *b, *last;
+    split(find_root(uv), i, a, rest);
+    split(rest, j-i+1, mid, c);
+    split(mid, 1, first, inner);
+    split(inner, size(inner)-1, b, last);
+    merge(c, a);
+  }
+
+  // sets the marks of x, and fixes the summaries up to the root
+  static void set_marks(EttNode* x, bool arc, bool vertex) {
+    x->arc_mark = arc;
+    x->vertex_mark = vertex;
+    for(; x; x = x->parent)
+      x->update();
+  }
+
+  // first node of tree t with an arc/vertex mark (0 if none)
+  static EttNode* find_marked(EttNode* t, bool arc) {
+    if(!t || !(arc ? t->any_arc : t->any_vertex))
+      return 0;
+    for(;;) {
+      EttNode* l = t->left;
+      if(l && (arc ? l->any_arc : l->any_vertex))
+        t = l;
+      else if(arc ? t->arc_mark : t->vertex_mark)
+        return t;
+      else
+        t = t->right;
+    }
+  }
+};
+
+class DynamicConnectivity {
+private:
+  // Level: the forest F_i and the non-tree edges of level i
+  struct Level {
+    EulerTourForest forest;
+    vector<vector<vertID> > nontree; // non-tree neighbors of each vertex
+  };
+
+  struct EdgeInfo {
+    unsigned level;
+    bool tree;
+    // non-tree: position in the lists of the lower and higher endpoint
+    unsigned pos[2];
+    // tree: arc nodes in F_0..F_level
+    vector<EttNode*> arcs;
+  };
+
+  unsigned nodes;
+  unsigned components;
+  vector<unique_ptr<Level> > levels; // built on first use
+  unordered_map<uint64_t,EdgeInfo> edges;
+
+  deque<EttNode> pool; // arc nodes (stable addresses)
+  vector<EttNode*> free_arcs;
+
+  static uint64_t key(vertID x, vertID y) {
+    if(x > y)
+      swap(x, y);
+    return (static_cast<uint64_t>(x) << 32) | y;
+  }
+
+  Level& level(unsigned i) {
+    while(levels.size() <= i) {
+      levels.push_back(unique_ptr<Level>(new Level()));
+      levels.back()->forest.reset(nodes);
+      levels.back()->nontree.resize(nodes);
+    }
+    return *levels[i];
+  }
+
+  EttNode* new_arc() {
+    if(free_arcs.empty()) {
+      pool.push_back(EttNode());
+      return &pool.back();
+    }
+    EttNode* x = free_arcs.back();
+    free_arcs.pop_back();
+    return x;
+  }
+
+  // marks vertex v of F_i when it has non-tree edges of level i
+  void update_vertex_mark(unsigned i, vertID v) {
+    Level& l = level(i);
+    EttNode* x = l.forest.get_vertex(v);
+    bool has = !l.nontree[v].empty();
+    if(x->vertex_mark != has)
+      EulerTourForest::set_marks(x, false, has);
+  }
+
+  void add_nontree(EdgeInfo& e, vertID x, vertID y, unsigned i) {
+    if(x > y)
+      swap(x, y);
+    Level& l = level(i);
+    e.level = i;
+    e.tree = false;
+    e.pos[0] = l.nontree[x].size();
+    l.nontree[x].push_back(y);
+    e.pos[1] = l.nontree[y].size();
+    l.nontree[y].push_back(x);
+    update_vertex_mark(i, x);
+    update_vertex_mark(i, y);
+  }
+
+  // removes y from the non-tree list of x at level i (slot 'pos')
+  void remove_from_list(unsigned i, vertID x, unsigned pos) {
+    vector<vertID>& list = level(i).nontree[x];
+    vertID moved = list.back();
+    list[pos] = moved;
+    list.pop_back();
+    if(pos < list.size()) {
+      // the edge (x,moved) changed slots
+      EdgeInfo& m = edges[key(x, moved)];
+      m.pos[x < moved ? 0 : 1] = pos;
+    }
+    update_vertex_mark(i, x);
+  }
+
+  void remove_nontree(EdgeInfo& e, vertID x, vertID y) {
+    if(x > y)
+      swap(x, y);
+    unsigned px = e.pos[0], py = e.pos[1];
+    remove_from_list(e.level, x, px);
+    remove_from_list(e.level, y, py);
+  }
+
+  // links edge (x,y) into F_0..F_i as a tree edge of level i
+  void add_tree(EdgeInfo& e, vertID x, vertID y, unsigned i) {
+    e.level = i;
+    e.tree = true;
+    e.arcs.clear();
+    for(unsigned j=0; j<=i; ++j) {
+      EttNode *xy = new_arc(), *yx = new_arc();
+      level(j).forest.link(x, y, xy, yx);
+      e.arcs.push_back(xy);
+      e.arcs.push_back(yx);
+    }
+    EulerTourForest::set_marks(e.arcs[2*i], true, false);
+  }
+
+  // cuts tree edge (x,y) from every forest it belongs to
+  void remove_tree(EdgeInfo& e) {
+    for(unsigned j=0; j<=e.level; ++j) {
+      EttNode *xy = e.arcs[2*j], *yx = e.arcs[2*j+1];
+      levels[j]->forest.cut(xy, yx);
+      free_arcs.push_back(xy);
+      free_arcs.push_back(yx);
+    }
+    e.arcs.clear();
+  }
+
+  // moves tree edge e from level i to level i+1
+  void raise_tree(EdgeInfo& e, unsigned i) {
+    EttNode* xy = e.arcs[2*i];
+    vertID x = xy->a, y = xy->b;
+    EulerTourForest::set_marks(xy, false, false);
+    EttNode *nxy = new_arc(), *nyx = new_arc();
+    level(i+1).forest.link(x, y, nxy, nyx);
+    e.arcs.push_back(nxy);
+    e.arcs.push_back(nyx);
+    e.level = i+1;
+    EulerTourForest::set_marks(nxy, true, false);
+  }
+
+  // looks for an edge that reconnects the trees of x and y after a tree
+  // edge of level 'top' between them was cut; returns true if found
+  bool replace(vertID x, vertID y, unsigned top) {
+    for(int i=top; i>=0; --i) {
+      EulerTourForest& f = level(i).forest;
+      // work on the smaller half
+      vertID v = (f.tree_size(x) <= f.tree_size(y)) ? x : y;
+
+      // raise its tree edges of level i
+      EttNode* arc;
+      while((arc = EulerTourForest::find_marked(
+               EulerTourForest::find_root(f.get_vertex(v)), true)))
+        raise_tree(edges[key(arc->a, arc->b)], i);
+
+      // scan its non-tree edges of level i
+      EttNode* w;
+      while((w = EulerTourForest::find_marked(
+               EulerTourForest::find_root(f.get_vertex(v)), false))) {
+        vertID a = w->a;
+        vector<vertID>& list = level(i).nontree[a];
+        while(!list.empty()) {
+          vertID b = list.back();
+          EdgeInfo& e = edges[key(a, b)];
+          remove_nontree(e, a, b);
+          if(f.connected(a, b)) {
+            add_nontree(e, a, b, i+1); // both ends in the half: raise it
+          } else {
+            add_tree(e, a, b, i); // reconnects the halves
+            return true;
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+public:
+  DynamicConnectivity(): nodes(0), components(0) {}
+  DynamicConnectivity(unsigned n) { reset(n); }
+
+  // n isolated vertices
+  void reset(unsigned n) {
+    nodes = n;
+    components = n;
+    levels.clear();
+    edges.clear();
+    pool.clear();
+    free_arcs.clear();
+    level(0);
+  }
+
+  unsigned get_nodes() const { return nodes; }
+  unsigned get_edges() const { return edges.size(); }
+  unsigned get_components() const { return components; }
+
+  bool has_edge(vertID x, vertID y) const {
+    return edges.count(key(x, y)) > 0;
+  }
+
+  bool connected(vertID x, vertID y) {
+    assert(x < nodes && y < nodes);
+    return levels[0]->forest.connected(x, y);
+  }
+
+  // number of vertices in the component of v
+  unsigned component_size(vertID v) {
+    assert(v < nodes);
+    return levels[0]->forest.tree_size(v);
+  }
+
+  // adds edge (x,y); returns false for loops and edges that already exist
+  bool insert(vertID x, vertID y) {
+    assert(x < nodes && y < nodes);
+    if(x == y || has_edge(x, y))
+      return false;
+
+    EdgeInfo& e = edges[key(x, y)];
+    if(!connected(x, y)) {
+      add_tree(e, x, y, 0);
+      components--;
+    } else {
+      add_nontree(e, x, y, 0);
+    }
+    return true;
+  }
+
+  // removes edge (x,y); returns false if there was none
+  bool erase(vertID x, vertID y) {
+    assert(x < nodes && y < nodes);
+    unordered_map<uint64_t,EdgeInfo>::iterator it = edges.find(key(x, y));
+    if(it == edges.end())
+      return false;
+
+    EdgeInfo& e = it->second;
+    if(!e.tree) {
+      remove_nontree(e, x, y);
+      edges.erase(it);
+      return true;
+    }
+
+    unsigned top = e.level;
+    remove_tree(e);
+    edges.erase(it);
+    if(!replace(x, y, top))
+      components++;
+    return true;
+  }
+};
+
+// ConnectivityGraph: a Graph whose connectivity is maintained as edges
+// come and go (use add_edge/del_edge of this class, not of the base)
+template <class vtype, class etype, class index = ScanIndex,
+          class storage = HeapStorage, class idtype = vertID>
+class ConnectivityGraph: public Graph<vtype,etype,index,storage,idtype> {
+private:
+  typedef Graph<vtype,etype,index,storage,idtype> Base;
+  DynamicConnectivity conn;
+
+public:
+  // n vertices with key 'key' and no edges
+  ConnectivityGraph(unsigned n = 0, vtype key = vtype()) { reset(n, key); }
+
+  void reset(unsigned n, vtype key = vtype()) {
+    Base::clear();
+    for(vertID i=0; i<n; ++i)
+      Base::add_vertex(key);
+    conn.reset(n);
+  }
+
+  void add_edge(vertID x, vertID y, etype weight) {
+    Base::add_edge(x, y, weight);
+    conn.insert(x, y);
+  }
+
+  bool del_edge(vertID x, vertID y) {
+    if(!Base::del_edge(x, y))
+      return false;
+    conn.erase(x, y);
+    return true;
+  }
+
+  bool is_connected(vertID x, vertID y) { return conn.connected(x, y); }
+  unsigned get_components() const { return conn.get_components(); }
+  unsigned get_component_size(vertID v) { return conn.component_size(v); }
+};
+#endif
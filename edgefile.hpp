@@ -0,0 +1,154 @@
+// -------------------------------------------------------------------
+// edgefile.hpp
+//
+// Edge files: a binary list of undirected weighted edges, meant for
+// streaming large generated graphs to disk and reading them back. The
+// file starts with a fixed header:
+//
+//   char magic[4] = "HEXE", uint32 version, uint32 nodes, uint32 unused,
+//   uint64 edges
+//
+// followed by 'edges' records of {uint32 x, uint32 y, float weight}, all
+// in the byte order of the machine that wrote the file. Edges are
+// written and read in large blocks.
+// author: Luiz Ramos
+
+#ifndef EDGEFILE_HPP
+#define EDGEFILE_HPP
+
+#include <cstdio> // FILE, fopen, fread, fwrite
+#include <cstring> // memcmp, memcpy
+#include <cstdint> // uint32_t, uint64_t
+#include <vector>
+#include "graph.hpp"
+using namespace std;
+
+struct EdgeFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t nodes;
+  uint32_t unused;
+  uint64_t edges;
+};
+
+struct EdgeRecord {
+  uint32_t x, y;
+  float weight;
+};
+
+const uint32_t EDGEFILE_VERSION = 1;
+
+// EdgeFileWriter: appends edges to a new edge file; the header is
+// completed by close()
+class EdgeFileWriter {
+private:
+  static const size_t BUFFER = 1 << 16; // records per write
+
+  FILE* file;
+  EdgeFileHeader header;
+  vector<EdgeRecord> buffer;
+  bool ok; // no I/O error so far
+
+  void flush() {
+    if(file && !buffer.empty() &&
+       fwrite(buffer.data(), sizeof(EdgeRecord), buffer.size(), file) !=
+       buffer.size())
+      ok = false;
+    buffer.clear();
+  }
+
+  EdgeFileWriter(const EdgeFileWriter&); // no copies
+  EdgeFileWriter& operator=(const EdgeFileWriter&);
+
+public:
+  EdgeFileWriter(): file(0), ok(false) {}
+
+  // creates the file for a graph with 'nodes' vertices; false on error
+  bool open(const char* path, unsigned nodes) {
+    close();
+    file = fopen(path, "wb");
+    if(!file)
+      return false;
+
+    memcpy(header.magic, "HEXE", 4);
+    header.version = EDGEFILE_VERSION;
+    header.nodes = nodes;
+    header.unused = 0;
+    header.edges = 0;
+    buffer.reserve(BUFFER);
+    ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+    return ok;
+  }
+
+  void add_edge(vertID x, vertID y, double weight) {
+    EdgeRecord r = {x, y, static_cast<float>(weight)};
+    buffer.push_back(r);
+    header.edges++;
+    if(buffer.size() == BUFFER)
+      flush();
+  }
+
+  uint64_t get_edges() const { return header.edges; }
+
+  // writes the pending edges and the final header; false if anything
+  // failed since open()
+  bool close() {
+    if(!file)
+      return false;
+    flush();
+    if(fseek(file, 0, SEEK_SET) != 0 ||
+       fwrite(&header, sizeof(header), 1, file) != 1)
+      ok = false;
+    if(fclose(file) != 0)
+      ok = false;
+    file = 0;
+    return ok;
+  }
+
+  ~EdgeFileWriter() { close(); }
+};
+
+// read_edge_file: replaces the contents of g with the graph of an edge
+// file (vertex keys are the vertex IDs); returns false if the file can't
+// be read or isn't an edge file
+template <class graph_t>
+bool read_edge_file(const char* path, graph_t& g) {
+  FILE* file = fopen(path, "rb");
+  if(!file)
+    return false;
+
+  EdgeFileHeader header;
+  if(fread(&header, sizeof(header), 1, file) != 1 ||
+     memcmp(header.magic, "HEXE", 4) != 0 ||
+     header.version != EDGEFILE_VERSION) {
+    fclose(file);
+    return false;
+  }
+
+  g.clear();
+  for(vertID i=0; i<header.nodes; ++i)
+    g.add_vertex(i);
+
+  vector<EdgeRecord> buffer(1 << 16);
+  uint64_t left = header.edges;
+  bool ok = true;
+  while(left > 0 && ok) {
+    size_t n = (left < buffer.size()) ? left : buffer.size();
+    if(fread(buffer.data(), sizeof(EdgeRecord), n, file) != n) {
+      ok = false;
+      break;
+    }
+    for(size_t i=0; i<n; ++i) {
+      const EdgeRecord& r = buffer[i];
+      if(r.x >= header.nodes || r.y >= header.nodes || r.x == r.y) {
+        ok = false;
+        break;
+      }
+      g.add_edge(r.x, r.y, r.weight);
+    }
+    left -= n;
+  }
+  fclose(file);
+  return ok;
+}
+#endif
@@ -0,0 +1,346 @@
+//--------------------------------------------------------------------
+// Hex Game
+// author: Luiz Ramos
+
+// FixedHexBoard<N>: a  Hex board whose  dimension is known  at compile
+// time.  It uses  the same  vertex IDs  as HexBoard (a  (N+2)x(N+2) grid
+// with margins), but  every geometric quantity is a  constant: the row
+// stride, the position  of the walls and the six  neighbor offsets. The
+// colors live  in a fixed std::array,  so a board can  be kept on the
+// stack and copied without allocations, and loops over the neighbors
+// are fully unrolled by the compiler.
+
+// There is no graph here: a playable vertex always has its six
+// neighbors inside the grid (the margins surround it), so we never need
+// bounds checks. To detect victory after a move, we flood the group of
+// the new stone and check if it touches both walls of its color; to test
+// a whole board (is_victory), we collect the stones of the player into a
+// bitset and use the bit-parallel flood fill of the bitboards.
+
+// dispatch_board_size selects the specialization for a dimension known
+// only at runtime (3..FIXED_MAX_DIM); other sizes should use the generic
+// HexBoard. The flat Monte Carlo player (aiplayer.hpp) runs its playouts
+// this way.
+
+#ifndef FIXEDBOARD_HPP
+#define FIXEDBOARD_HPP
+
+#include <array>
+#include <vector>
+#include <cassert>
+#include <cstdint> // uint64_t
+#ifdef __SSE2__
+#include <emmintrin.h> // _mm_cmpeq_epi8, _mm_movemask_epi8
+#endif
+#include "hexboard.hpp"
+using namespace std;
+
+// largest dimension handled by dispatch_board_size
+const unsigned FIXED_MAX_DIM = 19;
+
+// returns a mask with bit i set if p[i] == c, for i < n <= 64; with SSE2
+// we compare 16 bytes at a time and collect the results with movemask
+inline uint64_t match_bytes(const char* p, unsigned n, char c) {
+  uint64_t mask = 0;
+  unsigned i = 0;
+#ifdef __SSE2__
+  __m128i key = _mm_set1_epi8(c);
+  for(; i+16 <= n; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p+i));
+    uint64_t eq = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v,
+                                                                         key)));
+    mask |= eq << i;
+  }
+#endif
+  for(; i<n; ++i)
+    mask |= static_cast<uint64_t>(p[i] == c) << i;
+  return mask;
+}
+
+template <unsigned N>
+class FixedHexBoard {
+public:
+  // dimension of the board without margins (visible-only)
+  static const vertID REL_DIM = N;
+  // dimension of the board with margins (visible+invisible)
+  static const vertID ABS_DIM = N+2;
+  // number of vertices, margins included
+  static const vertID NODES = ABS_DIM * ABS_DIM;
+  // words of a mask with one bit per vertex
+  static const unsigned MASK_WORDS = (NODES+63) / 64;
+
+  // compile-time versions of the Transpose functors of HexBoard
+  static constexpr vertID abs_pos(vertID row, vertID col) {
+    return row*ABS_DIM + col;
+  }
+  static constexpr vertID rel_pos(vertID row, vertID col) {
+    return (row+1)*ABS_DIM + (col+1);
+  }
+
+  // offset of the i-th neighbor (same order as HexTopology::neighbors)
+  static constexpr int offset(unsigned i) {
+    return (i == 0) ? -1 :
+           (i == 1) ? 1 :
+           (i == 2) ? -static_cast<int>(ABS_DIM) :
+           (i == 3) ? -static_cast<int>(ABS_DIM)+1 :
+           (i == 4) ? static_cast<int>(ABS_DIM) :
+                      static_cast<int>(ABS_DIM)-1;
+  }
+
+  // verifies if x is part of the visible (playable) board
+  static constexpr bool is_playable(vertID x) {
+    return (x / ABS_DIM) >= 1 && (x / ABS_DIM) <= N &&
+           (x % ABS_DIM) >= 1 && (x % ABS_DIM) <= N;
+  }
+
+private:
+  static_assert(N > 2, "board too small");
+  static_assert(N <= BB_MAX_DIM, "is_victory needs a bitboard of this size");
+
+  // information needed to retract one move
+  struct Move {
+    vertID vert; // vertex that received the stone
+    bool p1_turn; // side to move before the move
+  };
+
+  array<Color,NODES> cells; // color of every vertex (margins included)
+  array<Move,N*N> moves; // moves that can be undone
+  unsigned nmoves; // number of entries in moves
+  bool p1_turn; // it's either player1's turn(true) or player2's turn(false)
+
+  static vertID neighbor(vertID x, unsigned i) {
+    return static_cast<vertID>(static_cast<int>(x) + offset(i));
+  }
+
+  // floods the group of the stone at v and reports if it touches both walls
+  // of its color
+  bool connects_walls(vertID v) const {
+    Color sym = cells[v];
+    array<bool,NODES> seen;
+    seen.fill(false);
+    array<vertID,N*N> stack;
+    unsigned top = 0;
+    bool first = false, last = false;
+
+    stack[top++] = v;
+    seen[v] = true;
+    while(top > 0) {
+      vertID x = stack[--top];
+      for(unsigned i=0; i<6; ++i) {
+        vertID y = neighbor(x, i);
+        if(seen[y] || cells[y] != sym)
+          continue;
+        seen[y] = true;
+
+        if(is_playable(y)) {
+          stack[top++] = y;
+        } else if(sym == Color::BLUE) {
+          // the only BLUE margins are the left and right walls
+          ((y % ABS_DIM == 0) ? first : last) = true;
+        } else {
+          // the only RED margins are the top and bottom walls
+          ((y < ABS_DIM) ? first : last) = true;
+        }
+
+        if(first && last)
+          return true;
+      }
+    }
+    return false;
+  }
+
+public:
+  FixedHexBoard() { reset_board(); }
+
+  // builds a new board ready to begin playing
+  void reset_board() {
+    cells.fill(Color::WHITE);
+    for(vertID i=0; i<ABS_DIM; ++i) {
+      // setting up the RED wall
+      cells[abs_pos(0,i)] = cells[abs_pos(ABS_DIM-1,i)] = Color::RED;
+      // setting up the BLUE wall
+      cells[abs_pos(i,0)] = cells[abs_pos(i,ABS_DIM-1)] = Color::BLUE;
+    }
+    // setting up the gray spots
+    cells[abs_pos(0,0)] = cells[abs_pos(0,ABS_DIM-1)] = Color::GRAY;
+    cells[abs_pos(ABS_DIM-1,0)] = Color::GRAY;
+    cells[abs_pos(ABS_DIM-1,ABS_DIM-1)] = Color::GRAY;
+
+    nmoves = 0;
+    p1_turn = true; // we always begin with player 1
+  }
+
+  // tries to play a move
+  Outcome play(int rowi, int coli) {
+    vertID row = static_cast<vertID>(rowi);
+    vertID col = static_cast<vertID>(coli);
+    if(!(row < N && col < N))
+      return Outcome::OOB_ERROR; // illegal move: out-of-bounds
+    return play_vertex(rel_pos(row,col));
+  }
+
+  // tries to play a move, addressing the position by its vertex ID
+  Outcome play_vertex(vertID v) {
+    if(v >= NODES || !is_playable(v))
+      return Outcome::OOB_ERROR; // illegal move: out-of-bounds
+    if(cells[v] != Color::WHITE)
+      return Outcome::OCC_ERROR; // illegal move: position occupied
+
+    Move m = {v, p1_turn};
+    moves[nmoves++] = m;
+    cells[v] = get_current_player_symbol();
+    if(connects_walls(v))
+      return (p1_turn ? Outcome::P1_WIN : Outcome::P2_WIN);
+
+    p1_turn = !p1_turn; // switch to opposite player
+    return Outcome::NO_WIN; // legal move, no winner
+  }
+
+  // retracts the last move made with play/play_vertex
+  void undo() {
+    assert(nmoves > 0);
+    Move m = moves[--nmoves];
+    cells[m.vert] = Color::WHITE;
+    p1_turn = m.p1_turn;
+  }
+
+  // number of moves that can be undone
+  unsigned get_move_count() const { return nmoves; }
+
+  // return information about the current player
+  int get_current_player() const { return (p1_turn ? 1 : 2); }
+  Color get_current_player_symbol() const {
+    return (p1_turn ? Color::BLUE : Color::RED);
+  }
+
+  // returns the dimension of the playable area of the board
+  int get_playable_dim() const { return static_cast<int>(N); }
+  unsigned get_nodes() const { return NODES; }
+
+  Color get_vertex_key(vertID x) const {
+    assert(x < NODES);
+    return cells[x];
+  }
+
+  // modifies the color of a vertex (not recorded as a move)
+  void set_vertex_key(vertID x, Color key) {
+    assert(x < NODES);
+    cells[x] = key;
+  }
+
+  // sets bit x%64 of mask[x/64] for every blank vertex x (the margins are
+  // never blank, so these are the free playable positions)
+  void get_free_mask(array<uint64_t,MASK_WORDS>& mask) const {
+    const char* c = reinterpret_cast<const char*>(cells.data());
+    for(unsigned k=0; k<MASK_WORDS; ++k) {
+      unsigned n = (NODES - 64*k < 64) ? NODES - 64*k : 64;
+      mask[k] = match_bytes(c + 64*k, n, static_cast<char>(Color::WHITE));
+    }
+  }
+
+  // fills the free vector with all blank positions on the board (in
+  // increasing order)
+  void get_free_vertices(vector<vertID>& fvert) const {
+    array<uint64_t,MASK_WORDS> mask;
+    get_free_mask(mask);
+    fvert.clear();
+    append_bits(mask.data(), MASK_WORDS, fvert);
+  }
+
+  // returns the number of blank positions on the board
+  unsigned count_free_vertices() const {
+    array<uint64_t,MASK_WORDS> mask;
+    get_free_mask(mask);
+    unsigned n = 0;
+    for(unsigned k=0; k<MASK_WORDS; ++k)
+      n += __builtin_popcountll(mask[k]);
+    return n;
+  }
+
+  // translates a vertex number into a row,col coordinate
+  void vertex_to_row_col(vertID vert, int& row, int& col) const {
+    row = static_cast<int>(vert / ABS_DIM)-1;
+    col = static_cast<int>(vert % ABS_DIM)-1;
+  }
+
+  // copies the colors and the side to move of a (generic) HexBoard of the
+  // same dimension; the move stack starts empty
+  void clone_board_state(HexBoard& other) {
+    assert(other.get_playable_dim() == static_cast<int>(N));
+    for(vertID i=0; i<NODES; ++i)
+      cells[i] = other.get_vertex_key(i);
+    nmoves = 0;
+    p1_turn = (other.get_current_player() == 1);
+  }
+
+  // copies the stones and the side to move of position p (of a board of
+  // the same dimension); the move stack starts empty
+  void set_position(const HexTopology& t, const HexPosition& p) {
+    assert(t.get_playable_dim() == N);
+    reset_board();
+    for(vertID row=0; row<N; ++row)
+      for(vertID col=0; col<N; ++col)
+        cells[rel_pos(row,col)] = p.get_stone(t.vertex(row,col));
+    p1_turn = p.is_p1_turn();
+  }
+
+  // determines if the player with color 'sym' has won: the stones of sym
+  // go into a bitset (16 cells at a time with SSE2), and the bit-parallel
+  // flood fill of bitboard.hpp does the rest
+  bool is_victory(Color sym) const {
+    const char* c = reinterpret_cast<const char*>(cells.data());
+    BitSet mine;
+    for(unsigned k=0; k<MASK_WORDS; ++k) {
+      unsigned n = (NODES - 64*k < 64) ? NODES - 64*k : 64;
+      mine.w[k] = match_bytes(c + 64*k, n, static_cast<char>(sym));
+    }
+    // the walls have the color of their player too, but the flood fill
+    // needs them empty (they are its guards)
+    const BitMasks& m = get_masks();
+    return m.is_victory(mine & m.get_playable(), (sym == Color::BLUE) ? 0 : 1);
+  }
+
+  // the bitboard masks of this size (built once, shared by every board)
+  static const BitMasks& get_masks() {
+    static const BitMasks masks = [] {
+      BitMasks m;
+      m.reset(N);
+      return m;
+    }();
+    return masks;
+  }
+};
+
+// dispatch_board_size: calls f.template run<N>() when FixedHexBoard<N>
+// exists for dim (3..FIXED_MAX_DIM), or f.run_generic(dim) otherwise. The
+// functor must provide both, with the same return type, e.g.:
+//
+//   struct Playouts {
+//     template <unsigned N> int run() { FixedHexBoard<N> b; ... }
+//     int run_generic(unsigned dim) { HexBoard b(dim); ... }
+//   };
+
+template <class F>
+auto dispatch_board_size(unsigned dim, F& f) -> decltype(f.run_generic(dim)) {
+  switch(dim) {
+    case 3: return f.template run<3>();
+    case 4: return f.template run<4>();
+    case 5: return f.template run<5>();
+    case 6: return f.template run<6>();
+    case 7: return f.template run<7>();
+    case 8: return f.template run<8>();
+    case 9: return f.template run<9>();
+    case 10: return f.template run<10>();
+    case 11: return f.template run<11>();
+    case 12: return f.template run<12>();
+    case 13: return f.template run<13>();
+    case 14: return f.template run<14>();
+    case 15: return f.template run<15>();
+    case 16: return f.template run<16>();
+    case 17: return f.template run<17>();
+    case 18: return f.template run<18>();
+    case 19: return f.template run<19>();
+    default: return f.run_generic(dim);
+  }
+}
+#endif
@@ -0,0 +1,181 @@
+//--------------------------------------------------------------------
+// Random graph generator
+// author: Luiz Ramos
+
+// Generates large random graphs (see generator.hpp) in parallel, either
+// into an edge file (see edgefile.hpp) or into a Graph in memory, and
+// reports how fast it went.
+//
+// usage: pgen <model> <a> <b> [-o file | -g file] [-s seed] [-t threads]
+//             [-w min max]
+//
+//   er N D        Erdos-Renyi graph, N vertices, average degree D
+//   grid R C      R x C square lattice
+//   hex R C       R x C hex lattice
+//   powerlaw N M  preferential attachment, M links per new vertex
+//
+// With -o, the edges are streamed into an edge file. Otherwise the graph
+// is built in a Graph and its degrees summarized; -g also saves it as a
+// graph file (see graphio.hpp) and times mapping it back.
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib> // atoi, atof
+#include <cstring> // strcmp
+#include <chrono>
+#include "graph.hpp"
+#include "generator.hpp"
+#include "edgefile.hpp"
+#include "graphio.hpp"
+#include "parallel.hpp"
+using namespace std;
+
+typedef Graph<vertID,double> WGraph;
+
+// EdgeFileSink: streams the generated edges into an edge file
+struct EdgeFileSink {
+  EdgeFileWriter& file;
+  const char* path;
+  bool ok;
+
+  EdgeFileSink(EdgeFileWriter& f, const char* p): file(f), path(p), ok(true) {}
+
+  void begin(unsigned nodes) { ok = file.open(path, nodes); }
+
+  void add_edges(const vector<GenEdge>& edges) {
+    if(!ok)
+      return;
+    for(size_t i=0; i<edges.size(); ++i)
+      file.add_edge(edges[i].x, edges[i].y, edges[i].weight);
+  }
+};
+
+void usage() {
+  cout << "usage: pgen <model> <a> <b> [-o file | -g file] [-s seed]"
+       << " [-t threads] [-w min max]" << endl
+       << "  er N D        Erdos-Renyi graph, N vertices, average degree D"
+       << endl
+       << "  grid R C      R x C square lattice" << endl
+       << "  hex R C       R x C hex lattice" << endl
+       << "  powerlaw N M  preferential attachment, M links per new vertex"
+       << endl;
+}
+
+double elapsed(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// saves g as a graph file, then maps it back and walks all its edges
+bool save_and_map(WGraph& g, const char* path) {
+  chrono::steady_clock::time_point t = chrono::steady_clock::now();
+  if(!write_graph(path, g))
+    return false;
+  cout << "saved " << path << " in " << fixed << setprecision(3)
+       << elapsed(t) << " s" << endl;
+
+  t = chrono::steady_clock::now();
+  MappedGraph<vertID,double> m;
+  if(!m.open(path))
+    return false;
+  double open = elapsed(t);
+  double sum = 0;
+  for(vertID v=0; v<m.get_nodes(); ++v)
+    for(unsigned i=0; i<m.get_degree(v); ++i)
+      sum += m.get_neighbor_weight(v, i);
+  cout << "mapped in " << setprecision(6) << open << " s, edges walked in "
+       << setprecision(3) << elapsed(t) - open << " s (total weight "
+       << setprecision(1) << sum / 2 << ")" << endl;
+  return m.get_edges() == g.get_edges();
+}
+
+// runs the model into the selected output and prints a summary
+template <class model_t>
+int run(const model_t& model, const char* path, const char* gpath,
+        uint64_t seed, unsigned threads) {
+  chrono::steady_clock::time_point t = chrono::steady_clock::now();
+  uint64_t edges;
+
+  if(path) {
+    EdgeFileWriter file;
+    EdgeFileSink sink(file, path);
+    generate(model, sink, seed, threads);
+    edges = file.get_edges();
+    if(!sink.ok || !file.close()) {
+      cerr << "pgen: can't write " << path << endl;
+      return 1;
+    }
+  } else {
+    WGraph g;
+    GraphSink<WGraph> sink(g);
+    generate(model, sink, seed, threads);
+    edges = g.get_edges();
+
+    unsigned maxdeg = 0;
+    for(vertID v=0; v<g.get_nodes(); ++v)
+      if(g.get_degree(v) > maxdeg)
+        maxdeg = g.get_degree(v);
+    cout << "average degree " << fixed << setprecision(2)
+         << 2.0 * edges / g.get_nodes() << ", maximum degree " << maxdeg
+         << endl;
+
+    if(gpath && !save_and_map(g, gpath)) {
+      cerr << "pgen: can't save " << gpath << endl;
+      return 1;
+    }
+  }
+
+  double secs = elapsed(t);
+  cout << model.get_nodes() << " nodes, " << edges << " edges in "
+       << fixed << setprecision(3) << secs << " s ("
+       << setprecision(2) << edges / secs / 1e6 << " Medges/s, "
+       << threads << " threads)" << endl;
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if(argc < 4) {
+    usage();
+    return 1;
+  }
+
+  const char* model = argv[1];
+  double a = atof(argv[2]), b = atof(argv[3]);
+  const char* path = 0; // edge file
+  const char* gpath = 0; // graph file
+  uint64_t seed = 1;
+  unsigned threads = default_threads();
+  WeightRange weight(1.0, 100.0);
+
+  for(int i=4; i<argc; ++i) {
+    if(strcmp(argv[i], "-o") == 0 && i+1 < argc) {
+      path = argv[++i];
+    } else if(strcmp(argv[i], "-g") == 0 && i+1 < argc) {
+      gpath = argv[++i];
+    } else if(strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+      seed = strtoull(argv[++i], 0, 10);
+    } else if(strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+      threads = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "-w") == 0 && i+2 < argc) {
+      weight.min = atof(argv[++i]);
+      weight.max = atof(argv[++i]);
+    } else {
+      usage();
+      return 1;
+    }
+  }
+  if(threads == 0)
+    threads = 1;
+
+  if(strcmp(model, "er") == 0 && a > 1 && b >= 0 && b < a) {
+    // average degree D: p = D / (N-1)
+    return run(ErdosRenyi(a, b / (a-1), weight), path, gpath, seed, threads);
+  } else if(strcmp(model, "grid") == 0 && a >= 1 && b >= 1) {
+    return run(Lattice(a, b, false, weight), path, gpath, seed, threads);
+  } else if(strcmp(model, "hex") == 0 && a >= 1 && b >= 1) {
+    return run(Lattice(a, b, true, weight), path, gpath, seed, threads);
+  } else if(strcmp(model, "powerlaw") == 0 && b >= 1 && a > b) {
+    return run(PreferentialAttachment(a, b, weight), path, gpath, seed, threads);
+  }
+  usage();
+  return 1;
+}
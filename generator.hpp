@@ -0,0 +1,362 @@
+// -------------------------------------------------------------------
+// generator.hpp
+//
+// Random graphs for testing and benchmarking the graph algorithms. The
+// generators take an explicit seed, so a run can always be repeated.
+
+// Large graphs are produced by models that split their edges into
+// independent blocks. Each block has its own random stream (derived from
+// the seed and the block number), so blocks can be generated by any
+// number of threads and the result is still the same for a given seed.
+// generate() runs the blocks in parallel and hands their edges, in block
+// order, to a sink (a Graph, an edge file, ...). The models are:
+//
+// ErdosRenyi: every pair of vertices is an edge with probability p. We
+// don't flip a coin per pair: the gap between two edges is geometric, so
+// we jump straight to the next edge (Batagelj and Brandes), in O(V+E).
+// Lattice: a rows x cols grid, either square (4 neighbors) or hex (6
+// neighbors, the pattern of HexTopology).
+// PreferentialAttachment: every new vertex links to m earlier vertices
+// picked with probability proportional to their degree (Barabasi and
+// Albert), which gives a power-law degree distribution. Each new vertex
+// depends on all the previous ones, so this model is a single block.
+// author: Luiz Ramos
+
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include <random>
+#include <vector>
+#include <algorithm> // shuffle
+#include <cassert>
+#include <cmath> // log, log1p, sqrt
+#include <cstdint> // uint64_t
+#include "graph.hpp"
+#include "parallel.hpp"
+using namespace std;
+
+// splitmix64: advances state and returns the next output; used to turn a
+// seed into well-mixed generator states
+inline uint64_t splitmix64(uint64_t& state) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// Xoshiro256: the xoshiro256** generator (Blackman and Vigna). Much faster
+// than mt19937 and with a 32-byte state, so every block of a generator can
+// have its own. It is a standard uniform random bit generator, so it also
+// works with the <random> distributions.
+class Xoshiro256 {
+private:
+  uint64_t s[4];
+
+  static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64-k)); }
+
+public:
+  typedef uint64_t result_type;
+  static constexpr uint64_t min() { return 0; }
+  static constexpr uint64_t max() { return ~static_cast<uint64_t>(0); }
+
+  Xoshiro256(uint64_t seed = 1) { reset(seed); }
+
+  void reset(uint64_t seed) {
+    uint64_t state = seed;
+    for(unsigned i=0; i<4; ++i)
+      s[i] = splitmix64(state);
+  }
+
+  uint64_t operator()() {
+    uint64_t r = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return r;
+  }
+
+  // uniform double in [0,1)
+  double uniform() {
+    return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  // uniform integer in [0,n) (Lemire's multiply-shift, without the
+  // rejection step: the bias is below n/2^64)
+  uint64_t below(uint64_t n) {
+    return static_cast<uint64_t>(
+      (static_cast<unsigned __int128>((*this)()) * n) >> 64);
+  }
+};
+
+// random_graph: fills g with 'nodes' vertices (the key of each vertex is
+// its ID) and 'edges' distinct random edges without loops, with weights
+// drawn uniformly from [min,max). A random spanning path is added first,
+// so the graph is connected whenever edges >= nodes-1.
+template <class graph_t>
+void random_graph(graph_t& g, unsigned nodes, unsigned edges,
+                  double min, double max, unsigned seed) {
+  assert(nodes > 1);
+  assert(edges <= static_cast<double>(nodes) * (nodes-1) / 2);
+  mt19937 gen(seed);
+  uniform_int_distribution<vertID> pick(0, nodes-1);
+  uniform_real_distribution<double> weight(min, max);
+
+  g.clear();
+  for(vertID i=0; i<nodes; ++i)
+    g.add_vertex(i);
+
+  // connect the vertices in a random order
+  vector<vertID> order(nodes);
+  for(vertID i=0; i<nodes; ++i)
+    order[i] = i;
+  shuffle(order.begin(), order.end(), gen);
+  for(vertID i=1; i<nodes && g.get_edges()<edges; ++i)
+    g.add_edge(order[i-1], order[i], weight(gen));
+
+  // then add random edges until we have enough (add_edge only updates the
+  // weight of edges that already exist)
+  while(g.get_edges() < edges) {
+    vertID x = pick(gen), y = pick(gen);
+    if(x != y)
+      g.add_edge(x, y, weight(gen));
+  }
+}
+// -------------------------------------------------------------------
+// Block models
+
+// GenEdge: an edge produced by a model
+typedef WeightedEdge<double> GenEdge;
+
+// weights of the generated edges: uniform in [min,max)
+struct WeightRange {
+  double min, max;
+
+  WeightRange(double lo = 1.0, double hi = 1.0): min(lo), max(hi) {}
+  double operator()(Xoshiro256& rng) const {
+    return min + (max-min) * rng.uniform();
+  }
+};
+
+class ErdosRenyi {
+private:
+  unsigned nodes;
+  double p;
+  WeightRange weight;
+  vector<vertID> first; // first row of each block (plus a sentinel)
+
+public:
+  static const unsigned BLOCK_EDGES = 1 << 20; // expected edges per block
+
+  // G(n,p) on 'n' vertices
+  ErdosRenyi(unsigned n, double prob, WeightRange w = WeightRange()):
+    nodes(n), p(prob), weight(w) {
+    assert(n > 1 && p >= 0 && p <= 1);
+    // vertex v is paired with 0..v-1: split the rows so that every block
+    // gets about the same number of pairs
+    double pairs = 0.5 * n * (n-1.0);
+    unsigned blocks = static_cast<unsigned>(pairs * p / BLOCK_EDGES) + 1;
+    if(blocks > n)
+      blocks = n;
+    first.push_back(1);
+    for(unsigned b=1; b<blocks; ++b) {
+      vertID row = static_cast<vertID>(sqrt(2.0 * pairs * b / blocks));
+      if(row > first.back() && row < n)
+        first.push_back(row);
+    }
+    first.push_back(n);
+  }
+
+  unsigned get_nodes() const { return nodes; }
+  unsigned get_blocks() const { return first.size()-1; }
+
+  void block(unsigned b, Xoshiro256& rng, vector<GenEdge>& out) const {
+    // log1p keeps tiny probabilities from rounding to log(1) = 0; the
+    // ones that still do are too small to give any edge
+    double lq = log1p(-p); // 0 ... -inf
+    if(p <= 0 || lq == 0)
+      return;
+    vertID last = first[b+1];
+    // candidate pairs (v,w) with w < v, in row-major order
+    uint64_t v = first[b];
+    int64_t w = -1;
+    while(v < last) {
+      // jump over the pairs that are not edges (a skip past the end of
+      // the block is clamped, so that it fits in an integer)
+      double skip = (p >= 1) ? 0 : log(1.0 - rng.uniform()) / lq;
+      double left = 0.5 * (last * (last-1.0) - v * (v-1.0)) - w;
+      if(skip > left)
+        skip = left;
+      w += 1 + static_cast<int64_t>(skip);
+      while(w >= static_cast<int64_t>(v) && v < last) {
+        w -= v;
+        v++;
+      }
+      if(v < last) {
+        GenEdge e = {weight(rng), static_cast<vertID>(v),
+                     static_cast<vertID>(w)};
+        out.push_back(e);
+      }
+    }
+  }
+};
+
+class Lattice {
+private:
+  unsigned rows, cols;
+  bool hex; // adds the (r,c)-(r+1,c-1) diagonals
+  WeightRange weight;
+
+public:
+  static const unsigned BLOCK_ROWS = 1024;
+
+  Lattice(unsigned r, unsigned c, bool hexagonal, WeightRange w = WeightRange()):
+    rows(r), cols(c), hex(hexagonal), weight(w) {
+    assert(r > 0 && c > 0);
+  }
+
+  unsigned get_nodes() const { return rows * cols; }
+  unsigned get_blocks() const { return (rows + BLOCK_ROWS-1) / BLOCK_ROWS; }
+
+  // block b holds the edges that leave rows [b*BLOCK_ROWS, ...) towards
+  // the right and downwards
+  void block(unsigned b, Xoshiro256& rng, vector<GenEdge>& out) const {
+    unsigned last = (b+1)*BLOCK_ROWS < rows ? (b+1)*BLOCK_ROWS : rows;
+    for(unsigned r=b*BLOCK_ROWS; r<last; ++r) {
+      for(unsigned c=0; c<cols; ++c) {
+        vertID v = r*cols + c;
+        if(c+1 < cols) {
+          GenEdge e = {weight(rng), v, v+1};
+          out.push_back(e);
+        }
+        if(r+1 < rows) {
+          GenEdge e = {weight(rng), v, v+cols};
+          out.push_back(e);
+          if(hex && c > 0) {
+            GenEdge d = {weight(rng), v, v+cols-1};
+            out.push_back(d);
+          }
+        }
+      }
+    }
+  }
+};
+
+class PreferentialAttachment {
+private:
+  unsigned nodes, m;
+  WeightRange weight;
+
+public:
+  // 'n' vertices, each new one linked to 'links' earlier vertices
+  PreferentialAttachment(unsigned n, unsigned links,
+                         WeightRange w = WeightRange()):
+    nodes(n), m(links), weight(w) {
+    assert(m > 0 && n > m);
+  }
+
+  unsigned get_nodes() const { return nodes; }
+  unsigned get_blocks() const { return 1; }
+
+  void block(unsigned, Xoshiro256& rng, vector<GenEdge>& out) const {
+    // every edge adds both endpoints to 'ends', so picking a random entry
+    // picks a vertex with probability proportional to its degree
+    vector<vertID> ends;
+    ends.reserve(2 * static_cast<size_t>(m) * nodes);
+
+    // start with a clique of m+1 vertices
+    for(vertID v=1; v<=m; ++v) {
+      for(vertID u=0; u<v; ++u) {
+        GenEdge e = {weight(rng), v, u};
+        out.push_back(e);
+        ends.push_back(v);
+        ends.push_back(u);
+      }
+    }
+
+    vector<vertID> picked;
+    for(vertID v=m+1; v<nodes; ++v) {
+      picked.clear();
+      while(picked.size() < m) {
+        vertID u = ends[rng.below(ends.size())];
+        if(find(picked.begin(), picked.end(), u) == picked.end())
+          picked.push_back(u);
+      }
+      for(unsigned i=0; i<m; ++i) {
+        GenEdge e = {weight(rng), v, picked[i]};
+        out.push_back(e);
+        ends.push_back(v);
+        ends.push_back(picked[i]);
+      }
+    }
+  }
+};
+
+// -------------------------------------------------------------------
+// Sinks: receive the generated graph. A sink provides
+//
+//   void begin(unsigned nodes);
+//   void add_edges(const vector<GenEdge>& edges);
+
+// GraphSink: builds the graph in a Graph (vertex keys are the IDs)
+template <class graph_t>
+struct GraphSink {
+  graph_t& g;
+
+  GraphSink(graph_t& graph): g(graph) {}
+
+  void begin(unsigned nodes) {
+    g.clear();
+    for(vertID i=0; i<nodes; ++i)
+      g.add_vertex(i);
+  }
+
+  void add_edges(const vector<GenEdge>& edges) {
+    for(size_t i=0; i<edges.size(); ++i)
+      g.add_edge(edges[i].x, edges[i].y, edges[i].weight);
+  }
+};
+
+// generates the graph of 'model' into 'sink': rounds of up to nthreads
+// blocks are generated in parallel, then passed to the sink in order
+template <class model_t, class sink_t>
+void generate(const model_t& model, sink_t& sink, uint64_t seed,
+              unsigned nthreads) {
+  struct Round {
+    const model_t& model;
+    uint64_t seed;
+    unsigned base; // first block of the round
+    vector<vector<GenEdge> >& out;
+
+    Round(const model_t& m, uint64_t s, unsigned b, vector<vector<GenEdge> >& o):
+      model(m), seed(s), base(b), out(o) {}
+
+    void operator()(unsigned, size_t first, size_t last) {
+      for(size_t i=first; i<last; ++i) {
+        // the stream of a block depends only on the seed and its number
+        uint64_t state = seed ^ (0x632be59bd9b4e019ULL * (base + i + 1));
+        Xoshiro256 rng(splitmix64(state));
+        out[i].clear();
+        model.block(base + i, rng, out[i]);
+      }
+    }
+  };
+
+  unsigned blocks = model.get_blocks();
+  if(nthreads == 0)
+    nthreads = 1;
+  vector<vector<GenEdge> > out(nthreads);
+
+  sink.begin(model.get_nodes());
+  for(unsigned base=0; base<blocks; base+=nthreads) {
+    unsigned n = (blocks - base < nthreads) ? blocks - base : nthreads;
+    Round round(model, seed, base, out);
+    parallel_for(n, n, round);
+    for(unsigned i=0; i<n; ++i)
+      sink.add_edges(out[i]);
+  }
+}
+#endif
@@ -13,7 +13,11 @@
 #include <iostream>
 #include <cstdlib>
 #include <vector>
+#include <cstdint> // uint64_t
+#include <limits> // numeric_limits
+#include <utility> // move
 #include <assert.h>
+#include "arena.hpp"
 using namespace std;
 
 // vertID: we  assume that the graph vertices  are uniquely identified
@@ -21,42 +25,221 @@ using namespace std;
 
 typedef unsigned vertID;
 
+// an ID that no vertex has (e.g., the parent of a root)
+const vertID NO_VERTEX = static_cast<vertID>(-1);
+
 // Edge: contains  a neighbor  ID and a  generic value of  custom type
 // (called  etype). The neighbor  is the  vertex that  has an  edge in
 // common  with the  current  vertex.  Val could  be,  for example,  a
 // floating-point weight or  a struct containing a string  label and a
-// double weight.
+// double weight. The neighbor is stored as an idtype: vertID by default,
+// or a narrower type (e.g. uint16_t) for graphs with few vertices.
 
-template <class etype> 
+template <class etype, class idtype = vertID>
 struct Edge {
-  vertID neigh;
+  idtype neigh;
   etype val;
 
   // constructors
   Edge(): neigh(0), val(0) {}
-  Edge(vertID neigh, etype val): neigh(neigh), val(val){}
+  Edge(vertID neigh, etype val): neigh(static_cast<idtype>(neigh)), val(val){}
+
+  etype get_val() const { return val; }
+  void set_val(etype v) { val = v; }
 
   // operator overload to facilitate viualizing edge
   friend ostream& operator<<
-  (ostream& out, Edge<etype>& e) {
-    out << "(" << e.neigh << "," << e.val << ")";
+  (ostream& out, Edge& e) {
+    out << "(" << static_cast<vertID>(e.neigh) << "," << e.val << ")";
     return out;
   }
 };
 
+// NoWeight: the edge value of unweighted graphs. Every edge weighs 1, and
+// the weights given to add_edge are dropped, so the edges need not store
+// anything (see the specialization of Edge below).
+struct NoWeight {
+  NoWeight() {}
+  NoWeight(double) {}
+  operator unsigned() const { return 1; }
+};
+
+// edges of unweighted graphs hold only the neighbor: with uint16_t IDs an
+// edge takes 2 bytes instead of 8
+template <class idtype>
+struct Edge<NoWeight,idtype> {
+  idtype neigh;
+
+  Edge(): neigh(0) {}
+  Edge(vertID neigh, NoWeight): neigh(static_cast<idtype>(neigh)) {}
+
+  NoWeight get_val() const { return NoWeight(); }
+  void set_val(NoWeight) {}
+
+  friend ostream& operator<<
+  (ostream& out, Edge& e) {
+    out << "(" << static_cast<vertID>(e.neigh) << ")";
+    return out;
+  }
+};
+
+// WeightedEdge: a  standalone undirected edge {x,y} (edge lists of
+// Kruskal, streams of generated edges, edge files)
+template <class etype>
+struct WeightedEdge {
+  etype weight;
+  vertID x, y;
+
+  bool operator<(const WeightedEdge& o) const { return weight < o.weight; }
+};
+
+// Adjacency indices: policies that decide how edges are located, given
+// as the  last template parameter of  Vertex and Graph. Each  policy has
+// two parts: static functions that  find, insert and erase edges in the
+// edge list of a vertex, and a graph-wide object that is told about every
+// vertex and edge and may answer is_adjacent on its own (has_matrix).
+//
+// ScanIndex: edges  kept unordered,  found by a linear scan, deleted by
+// moving the last edge into the hole. Best for small degrees (this is the
+// default, and what HexBoard uses).
+// SortedIndex: edges  kept sorted  by neighbor, found by binary search
+// in O(log d). Best for large sparse graphs with high-degree vertices.
+// BitMatrixIndex: a  V x V bit  matrix answers  is_adjacent in O(1);
+// weights are still found by a scan. Best for small or dense graphs.
+
+struct ScanIndex {
+  static const bool has_matrix = false;
+
+  // returns the position of neigh in edge list l, or -1 if not found
+  template <class elist_t>
+  static int find(const elist_t& l, vertID neigh) {
+    for(int i=0; i<l.size(); ++i) {
+      if(l[i].neigh == neigh) // lookup by vertID
+        return i;
+    }
+    return -1;
+  }
+
+  template <class elist_t, class edge_t>
+  static void insert(elist_t& l, const edge_t& e) { l.push_back(e); }
+
+  // the order of the list doesn't matter: the last edge takes the slot
+  template <class elist_t>
+  static void erase(elist_t& l, int i) {
+    l[i] = l.back();
+    l.pop_back();
+  }
+
+  // graph-wide hooks (nothing to maintain)
+  void resize(unsigned) {}
+  void link(vertID, vertID) {}
+  void unlink(vertID, vertID) {}
+  void clear() {}
+  bool test(vertID, vertID) const { return false; }
+};
+
+struct SortedIndex: public ScanIndex {
+  // binary search for the first edge whose neighbor is not below neigh
+  template <class elist_t>
+  static int lower_bound(const elist_t& l, vertID neigh) {
+    int lo = 0, hi = l.size();
+    while(lo < hi) {
+      int mid = (lo + hi) / 2;
+      if(l[mid].neigh < neigh)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+    return lo;
+  }
+
+  template <class elist_t>
+  static int find(const elist_t& l, vertID neigh) {
+    int i = lower_bound(l, neigh);
+    return (i < l.size() && l[i].neigh == neigh) ? i : -1;
+  }
+
+  template <class elist_t, class edge_t>
+  static void insert(elist_t& l, const edge_t& e) {
+    l.insert(l.begin() + lower_bound(l, e.neigh), e);
+  }
+
+  template <class elist_t>
+  static void erase(elist_t& l, int i) { l.erase(l.begin() + i); }
+};
+
+class BitMatrixIndex: public ScanIndex {
+private:
+  unsigned cap; // number of columns of each row (grows by doubling)
+  vector<uint64_t> bits; // row-major cap x cap matrix of bits
+
+  // position of bit (x,y) in the matrix (a large matrix has more bits
+  // than a vertID can count)
+  size_t bit(vertID x, vertID y) const {
+    return static_cast<size_t>(x)*cap + y;
+  }
+  uint64_t& word(vertID x, vertID y) { return bits[bit(x,y) >> 6]; }
+
+public:
+  static const bool has_matrix = true;
+
+  BitMatrixIndex(): cap(0) {}
+
+  // makes room for 'nodes' vertices; the matrix is laid out again only
+  // when the capacity doubles, so adding V vertices costs O(V^2) overall
+  void resize(unsigned nodes) {
+    if(nodes <= cap)
+      return;
+
+    unsigned ncap = (cap == 0 ? 64 : cap);
+    while(ncap < nodes)
+      ncap *= 2;
+
+    vector<uint64_t> nbits(static_cast<size_t>(ncap) * ncap / 64, 0);
+    for(vertID x=0; x<cap; ++x)
+      for(unsigned w=0; w<cap/64; ++w)
+        nbits[static_cast<size_t>(x)*ncap/64 + w] = bits[bit(x,0)/64 + w];
+    bits.swap(nbits);
+    cap = ncap;
+  }
+
+  void link(vertID x, vertID y) {
+    word(x,y) |= static_cast<uint64_t>(1) << (bit(x,y) & 63);
+    word(y,x) |= static_cast<uint64_t>(1) << (bit(y,x) & 63);
+  }
+
+  void unlink(vertID x, vertID y) {
+    word(x,y) &= ~(static_cast<uint64_t>(1) << (bit(x,y) & 63));
+    word(y,x) &= ~(static_cast<uint64_t>(1) << (bit(y,x) & 63));
+  }
+
+  void clear() {
+    cap = 0;
+    bits.clear();
+  }
+
+  bool test(vertID x, vertID y) const {
+    size_t i = bit(x,y);
+    return (bits[i >> 6] >> (i & 63)) & 1;
+  }
+};
+
 // Vertex/Node: contains  a value of custom  type and a  list of edges
 // (implemented as  an STL vector). Both  the value of  the vertex and
-// edge must be specified.
+// edge must be specified; idtype is the type of the neighbor IDs stored
+// in the edges (see Edge).
 
-template <class vtype, class etype>
+template <class vtype, class etype, class index = ScanIndex,
+          class storage = HeapStorage, class idtype = vertID>
 class Vertex {
 private: 
   // typedefs make the code clearer within this class
-  typedef Vertex<vtype,etype> CustomVertex;
-  typedef Edge<etype> CustomEdge;
+  typedef Vertex<vtype,etype,index,storage,idtype> CustomVertex;
+  typedef Edge<etype,idtype> CustomEdge;
+  typedef typename storage::template rebind<CustomEdge>::other EdgeAlloc;
 
   vtype key; // value stored in the node
-  vector<CustomEdge> elist; // list of edges
+  vector<CustomEdge,EdgeAlloc> elist; // list of edges
 
   // shows the neighbors of this vertex
   void print(ostream& out) {
@@ -68,24 +251,23 @@ private:
 
   // find: utility to find a specific neighbor of this vertex. Returns the
   // index of the found index or -1 if not found.
-  int find(vertID neigh) {
-    for(int i=0; i<elist.size(); ++i) {
-      if(elist[i].neigh == neigh) // lookup by vertID
-        return i;
-    }
-    return -1;
-  }
+  int find(vertID neigh) { return index::find(elist, neigh); }
 
 public:
   Vertex(): key(0) {}
   Vertex(vtype key): key(key) {}
+  // the edges will be allocated by 'alloc'
+  Vertex(vtype key, const EdgeAlloc& alloc): key(key), elist(alloc) {}
+  // copies v, allocating the edges with 'alloc'
+  Vertex(const Vertex& v, const EdgeAlloc& alloc):
+    key(v.key), elist(v.elist, alloc) {}
   vtype get_key() { return key; }
   void set_key(vtype key) { this->key = key; }
 
   // add: inserts an edge of weight 'weight' with vertice 'neigh'
   void add(vertID neigh, etype weight) {
     CustomEdge e(neigh, weight);
-    elist.push_back(e);
+    index::insert(elist, e);
   }
 
   // is_adjacent: check if this vertex is adjacent to neigh
@@ -98,14 +280,14 @@ public:
   etype get_weight(vertID neigh) {
     int i = find(neigh);
     assert(i >= 0);
-    return elist[i].val;
+    return elist[i].get_val();
   }
 
   // set_weight: modifies the edge weight. Note: the edge MUST exist.
   void set_weight(vertID neigh, etype weight) {
     int i = find(neigh);
     assert(i >= 0);
-    elist[i].val = weight;
+    elist[i].set_val(weight);
   }
 
   // del: removes an edge with the correct vertID from the connections
@@ -113,12 +295,24 @@ public:
   bool del(vertID neigh) {
     int i = find(neigh);
     if(i >= 0) {
-      elist.erase(elist.begin() + i);
+      index::erase(elist, i);
       return true; 
     }
     return false;
   }
 
+  // get_degree: returns the number of neighbors of this vertex
+  unsigned get_degree() { return elist.size(); }
+
+  // get_neighbor: returns the i-th neighbor of this vertex (no copies)
+  vertID get_neighbor(unsigned i) { return elist[i].neigh; }
+
+  // get_neighbor_weight: returns the weight of the edge to the i-th neighbor
+  etype get_neighbor_weight(unsigned i) { return elist[i].get_val(); }
+
+  // clear: removes all edges of this vertex
+  void clear() { elist.clear(); }
+
   // get_neighbors: returns a vector containing the vertIDs of all neighbors of
   // this vector.
   void get_neighbors(vector<vertID>& neigh) {
@@ -133,20 +327,34 @@ public:
     e.print(out);
     return out;
   }
-
-  // destructor: remove all neighbors
-  ~Vertex() { elist.clear(); } 
 };
 
-template <class vtype, class etype>
+// Graph: index and storage are the policies described above; idtype is
+// the type of the neighbor IDs kept in the edge lists, so a board with a
+// few hundred vertices can use Graph<..., uint16_t> (with NoWeight edges,
+// its edge lists shrink by 4x).
+template <class vtype, class etype, class index = ScanIndex,
+          class storage = HeapStorage, class idtype = vertID>
 class Graph {
 private:
   // typedefs make the code clearer within this class
-  typedef Vertex<vtype,etype> CustomVertex;
-  typedef Edge<etype> CustomEdge;
+  typedef Vertex<vtype,etype,index,storage,idtype> CustomVertex;
+  typedef Edge<etype,idtype> CustomEdge;
 
   unsigned nedges; // total number of edges
+  storage mem; // where the edge lists live (must outlive vlist)
   vector<CustomVertex> vlist; // list of vetices (and adjacencies)
+  index adj; // graph-wide part of the adjacency index
+
+  // copies the vertices and edges of g (*this must be empty)
+  void copy_from(const Graph& g) {
+    vlist.reserve(g.vlist.size());
+    for(vertID i=0; i<g.vlist.size(); ++i)
+      vlist.push_back(CustomVertex(g.vlist[i],
+                                   mem.template get_allocator<CustomEdge>()));
+    adj = g.adj;
+    nedges = g.nedges;
+  }
 
   // verify if the vertex index is within the allowed boundary
   void validate_vertex(vertID x) {
@@ -174,6 +382,37 @@ private:
 public:
   Graph(): nedges(0){}
 
+  // copies take O(V+E): the edge lists are copied as they are, so we never
+  // look edges up (the copy keeps its edges in its own storage)
+  Graph(const Graph& g): nedges(0) { copy_from(g); }
+
+  Graph& operator=(const Graph& g) {
+    if(this != &g) {
+      clear();
+      copy_from(g);
+    }
+    return *this;
+  }
+
+  // moves take over the vectors (and the storage) of g in O(1) and leave g
+  // empty
+  Graph(Graph&& g) noexcept:
+    nedges(g.nedges), mem(move(g.mem)), vlist(move(g.vlist)),
+    adj(move(g.adj)) {
+    g.clear();
+  }
+
+  Graph& operator=(Graph&& g) noexcept {
+    if(this != &g) {
+      nedges = g.nedges;
+      vlist = move(g.vlist); // our old edges go back to our old storage
+      mem = move(g.mem);
+      adj = move(g.adj);
+      g.clear();
+    }
+    return *this;
+  }
+
   // acessor methods
   unsigned get_nodes() { return vlist.size(); }
   unsigned get_edges() { return nedges; }
@@ -181,6 +420,8 @@ public:
   // verifies if there is an edge between x and y
   bool is_adjacent(vertID x, vertID y) {
     validate_vertices(x, y);
+    if(index::has_matrix)
+      return adj.test(x, y);
     return vlist[x].is_adjacent(y);
   }
 
@@ -205,11 +446,32 @@ public:
     vlist[v].get_neighbors(neigh);
   }
 
+  // returns the number of neighbors of v and its i-th neighbor, so that
+  // callers can walk the adjacency without copying it
+  unsigned get_degree(vertID v) { return vlist[v].get_degree(); }
+  vertID get_neighbor(vertID v, unsigned i) {
+    return vlist[v].get_neighbor(i);
+  }
+
+  // calls f(w) for every neighbor w of v (used by the traversals below)
+  template <class F>
+  void for_each_neighbor(vertID v, F& f) {
+    validate_vertex(v);
+    CustomVertex& x = vlist[v];
+    for(unsigned i=0; i<x.get_degree(); ++i)
+      f(x.get_neighbor(i));
+  }
+  etype get_neighbor_weight(vertID v, unsigned i) {
+    return vlist[v].get_neighbor_weight(i);
+  }
+
   // mutator methods
   // add a vertex to the graph 
   void add_vertex(vtype key) {
-    CustomVertex v(key);
-    vlist.push_back(v);
+    // the ID of the new vertex must fit in the edges
+    assert(vlist.size() <= numeric_limits<idtype>::max());
+    vlist.push_back(CustomVertex(key, mem.template get_allocator<CustomEdge>()));
+    adj.resize(vlist.size());
   }
 
   // adds an edge between vertices x and y and sets their weight
@@ -219,6 +481,7 @@ public:
     if(!is_adjacent(x,y)) {
       vlist[x].add(y, weight);
       vlist[y].add(x, weight);
+      adj.link(x, y);
       nedges++;
       //cout << "EDGE(" << x << "," << y << ")" << endl;
     } else {
@@ -230,6 +493,17 @@ public:
     add_edge(x, y, 1.0); // default weight
   }
 
+  // removes the edge between x and y; returns false if there was none
+  bool del_edge(vertID x, vertID y) {
+    validate_vertices(x, y);
+    if(!vlist[x].del(y))
+      return false;
+    vlist[y].del(x);
+    adj.unlink(x, y);
+    nedges--;
+    return true;
+  }
+
   // modifies the weight of the edge between x and y (the edge must exist)
   void set_edge_weight(vertID x, vertID y, etype weight) {
     validate_vertices(x, y);
@@ -251,29 +525,160 @@ public:
   }
 
   // deallocate al vertices and their respective adjacency lists
-  void clear() { vlist.clear(); }
+  void clear() { vlist.clear(); mem.release(); adj.clear(); nedges = 0; }
 
-  // creates a copy of g into *this
-  void clone(Graph<vtype,etype>& g) {
-    // copy all vertices
-    for(vertID i=0; i<g.get_nodes(); ++i) {
-      add_vertex(g.get_vertex_key(i));
-    }
+  // removes all edges, but keeps the vertices and their keys
+  void clear_edges() {
+    for(int i=0; i<vlist.size(); ++i)
+      vlist[i].clear();
+    adj.clear();
+    adj.resize(vlist.size());
+    nedges = 0;
+  }
 
-    // copy all edges: assumes that the graph is undirected and without loops
-    for(vertID i=0; i<g.get_nodes(); ++i) {
-      for(vertID j=0; j<i; ++j) {
-        if(g.is_adjacent(i,j)) {
-          add_edge(i, j, g.get_edge_weight(i,j));
-        }
-      }
+  // creates a copy of g into *this (same as an assignment)
+  void clone(const Graph& g) { *this = g; }
+};
+
+// -------------------------------------------------------------------
+// Traversals
+
+// TraversalWorkspace: the memory used by a search (visited marks and the
+// stack/queue of vertices), owned by the caller and reused by every
+// search. Instead of clearing the marks, each search takes a new
+// generation number: a vertex is visited iff its mark equals the current
+// generation. Once the arrays have grown to the size of the graph,
+// searches don't allocate anything.
+class TraversalWorkspace {
+private:
+  vector<unsigned> mark; // generation in which each vertex was visited
+  unsigned generation; // generation of the current search
+  vector<vertID> frontier; // stack (DFS) or queue (BFS) of vertices
+
+  template <class visitor_t> friend struct TraversalStep;
+  template <class graph_t, class visitor_t>
+  friend bool dfs(graph_t& g, vertID src, TraversalWorkspace& ws,
+                  visitor_t& vis);
+  template <class graph_t, class visitor_t>
+  friend bool bfs(graph_t& g, vertID src, TraversalWorkspace& ws,
+                  visitor_t& vis);
+
+public:
+  TraversalWorkspace(): generation(0) {}
+
+  // starts a new search over a graph with 'nodes' vertices
+  void begin(unsigned nodes) {
+    if(mark.size() < nodes)
+      mark.resize(nodes, generation);
+    if(++generation == 0) {
+      // the counter wrapped around: old marks could look current again
+      mark.assign(mark.size(), 0);
+      generation = 1;
     }
+    frontier.clear();
   }
 
-  // clears the graph for reuse
-  ~Graph() { clear(); }
+  bool is_visited(vertID v) const { return mark[v] == generation; }
+
+  // marks v as visited; returns false if it already was
+  bool visit(vertID v) {
+    if(mark[v] == generation)
+      return false;
+    mark[v] = generation;
+    return true;
+  }
 };
 
+// Visitors: the  traversals are templates on  the visitor type, so the
+// callbacks below are resolved at compile time and inlined. A visitor
+// provides:
+//
+//   bool follow(vertID from, vertID to); // may the search take this edge?
+//   bool discover(vertID v); // v was reached; return true to stop
+//
+// The graph must provide get_nodes() and for_each_neighbor(v, f).
+
+// TraversalStep: expands one vertex, offering its neighbors to the visitor
+template <class visitor_t>
+struct TraversalStep {
+  TraversalWorkspace& ws;
+  visitor_t& vis;
+  vertID from;
+  bool stop;
+
+  TraversalStep(TraversalWorkspace& w, visitor_t& v, vertID f):
+    ws(w), vis(v), from(f), stop(false) {}
+
+  void operator()(vertID to) {
+    if(stop || ws.is_visited(to) || !vis.follow(from, to))
+      return;
+    ws.visit(to);
+    if(vis.discover(to))
+      stop = true;
+    else
+      ws.frontier.push_back(to);
+  }
+};
+
+// depth-first search from src; returns true if the visitor stopped it
+template <class graph_t, class visitor_t>
+bool dfs(graph_t& g, vertID src, TraversalWorkspace& ws, visitor_t& vis) {
+  ws.begin(g.get_nodes());
+  ws.visit(src);
+  if(vis.discover(src))
+    return true;
+
+  ws.frontier.push_back(src);
+  while(!ws.frontier.empty()) {
+    vertID v = ws.frontier.back();
+    ws.frontier.pop_back();
+
+    TraversalStep<visitor_t> step(ws, vis, v);
+    g.for_each_neighbor(v, step);
+    if(step.stop)
+      return true;
+  }
+  return false;
+}
+
+// breadth-first search from src (vertices are discovered in order of
+// distance); returns true if the visitor stopped it
+template <class graph_t, class visitor_t>
+bool bfs(graph_t& g, vertID src, TraversalWorkspace& ws, visitor_t& vis) {
+  ws.begin(g.get_nodes());
+  ws.visit(src);
+  if(vis.discover(src))
+    return true;
+
+  // the queue is the frontier vector itself, read from 'head' onwards
+  ws.frontier.push_back(src);
+  for(size_t head=0; head<ws.frontier.size(); ++head) {
+    vertID v = ws.frontier[head];
+
+    TraversalStep<visitor_t> step(ws, vis, v);
+    g.for_each_neighbor(v, step);
+    if(step.stop)
+      return true;
+  }
+  return false;
+}
+
+// ReachVisitor: follows every edge and stops when it finds dst
+struct ReachVisitor {
+  vertID dst;
+
+  ReachVisitor(vertID d): dst(d) {}
+  bool follow(vertID, vertID) { return true; }
+  bool discover(vertID v) { return v == dst; }
+};
+
+// verifies if there is a path between src and dst
+template <class graph_t>
+bool is_reachable(graph_t& g, vertID src, vertID dst, TraversalWorkspace& ws) {
+  ReachVisitor vis(dst);
+  return dfs(g, src, ws, vis);
+}
+
 #if 0
 // -------------------------------------------------------------------
 // testing functions
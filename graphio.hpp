@@ -0,0 +1,388 @@
+// -------------------------------------------------------------------
+// graphio.hpp
+//
+// Graph files: a binary image of a graph in CSR form (see csrgraph.hpp)
+// that can be used straight from a memory mapping, without parsing. The
+// file is:
+//
+//   header (GraphFileHeader, 64 bytes)
+//   keys[nodes]        vertex keys (vtype)
+//   offsets[nodes+1]   uint64: first adjacency of each vertex
+//   targets[arcs]      uint32: neighbor IDs, grouped by vertex
+//   weights[arcs]      edge values (etype), parallel to targets
+//
+// where arcs = 2*edges (every edge is listed by both endpoints). Each
+// section starts at a multiple of 64 bytes, and the header records the
+// sizes of vtype and etype, so a file is only opened with the types it
+// was written with. Keys and weights are copied byte by byte, so they
+// must be trivially copyable types (numbers, enums, plain structs).
+// Files use the byte order of the machine that wrote them.
+//
+// write_graph saves a Graph, a CSRGraph or a HexBoard (with the adjacency
+// of its topology, whether it is stored or computed); MappedGraph maps a
+// file and answers the same read-only queries as a CSRGraph (the OS loads
+// pages on demand, so opening a huge graph takes microseconds); load_graph
+// rebuilds a mutable Graph from a file.
+// author: Luiz Ramos
+
+#ifndef GRAPHIO_HPP
+#define GRAPHIO_HPP
+
+#include <cstdio> // FILE, fopen, fwrite
+#include <cstring> // memcmp, memcpy
+#include <cstdint> // uint32_t, uint64_t
+#include <type_traits> // is_trivially_copyable
+#include <vector>
+#include <sys/mman.h> // mmap
+#include <sys/stat.h> // fstat
+#include <fcntl.h> // open
+#include <unistd.h> // close
+#include "graph.hpp"
+#include "csrgraph.hpp"
+#include "hexboard.hpp"
+using namespace std;
+
+struct GraphFileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t key_size; // sizeof(vtype)
+  uint32_t weight_size; // sizeof(etype)
+  uint64_t nodes;
+  uint64_t arcs;
+  // position of each section from the start of the file
+  uint64_t keys, offsets, targets, weights;
+};
+
+const uint32_t GRAPHFILE_VERSION = 1;
+const uint64_t GRAPHFILE_ALIGN = 64;
+
+// first multiple of GRAPHFILE_ALIGN at or after pos
+inline uint64_t graphfile_align(uint64_t pos) {
+  return (pos + GRAPHFILE_ALIGN-1) & ~(GRAPHFILE_ALIGN-1);
+}
+
+// fills the header of a file with the given types and sizes
+template <class vtype, class etype>
+GraphFileHeader make_graphfile_header(uint64_t nodes, uint64_t arcs) {
+  GraphFileHeader h;
+  memset(&h, 0, sizeof(h));
+  memcpy(h.magic, "HEXG", 4);
+  h.version = GRAPHFILE_VERSION;
+  h.key_size = sizeof(vtype);
+  h.weight_size = sizeof(etype);
+  h.nodes = nodes;
+  h.arcs = arcs;
+  h.keys = graphfile_align(sizeof(GraphFileHeader));
+  h.offsets = graphfile_align(h.keys + nodes * sizeof(vtype));
+  h.targets = graphfile_align(h.offsets + (nodes+1) * sizeof(uint64_t));
+  h.weights = graphfile_align(h.targets + arcs * sizeof(uint32_t));
+  return h;
+}
+
+// GraphFileWriter: writes the sections in order, padding between them
+class GraphFileWriter {
+private:
+  FILE* file;
+  uint64_t pos; // bytes written so far
+  bool ok;
+
+  GraphFileWriter(const GraphFileWriter&); // no copies
+  GraphFileWriter& operator=(const GraphFileWriter&);
+
+public:
+  GraphFileWriter(const char* path): pos(0), ok(true) {
+    file = fopen(path, "wb");
+    ok = (file != 0);
+  }
+
+  void write(const void* data, size_t bytes) {
+    if(ok && bytes > 0 && fwrite(data, 1, bytes, file) != bytes)
+      ok = false;
+    pos += bytes;
+  }
+
+  // pads the file up to position 'to'
+  void seek(uint64_t to) {
+    static const char zeros[GRAPHFILE_ALIGN] = {0};
+    while(pos < to)
+      write(zeros, (to-pos < GRAPHFILE_ALIGN) ? to-pos : GRAPHFILE_ALIGN);
+  }
+
+  bool close() {
+    if(file && fclose(file) != 0)
+      ok = false;
+    file = 0;
+    return ok;
+  }
+
+  ~GraphFileWriter() { close(); }
+};
+
+// saves any graph with get_nodes, get_vertex_key, get_degree, get_neighbor
+// and get_neighbor_weight; returns false on I/O errors
+template <class vtype, class etype, class graph_t>
+bool write_graph_file(const char* path, graph_t& g) {
+  static_assert(is_trivially_copyable<vtype>::value &&
+                is_trivially_copyable<etype>::value,
+                "keys and weights are saved byte by byte");
+  uint64_t n = g.get_nodes(), arcs = 0;
+  for(vertID v=0; v<n; ++v)
+    arcs += g.get_degree(v);
+  GraphFileHeader h = make_graphfile_header<vtype,etype>(n, arcs);
+
+  GraphFileWriter out(path);
+  out.write(&h, sizeof(h));
+
+  // every section goes out in blocks, through a small buffer
+  const unsigned BLOCK = 1 << 14;
+  vector<vtype> keys;
+  vector<uint64_t> offsets;
+  vector<uint32_t> targets;
+  vector<etype> weights;
+
+  out.seek(h.keys);
+  for(vertID v=0; v<n; ++v) {
+    keys.push_back(g.get_vertex_key(v));
+    if(keys.size() == BLOCK || v+1 == n) {
+      out.write(keys.data(), keys.size() * sizeof(vtype));
+      keys.clear();
+    }
+  }
+
+  out.seek(h.offsets);
+  uint64_t first = 0;
+  for(vertID v=0; v<=n; ++v) {
+    offsets.push_back(first);
+    if(v < n)
+      first += g.get_degree(v);
+    if(offsets.size() == BLOCK || v == n) {
+      out.write(offsets.data(), offsets.size() * sizeof(uint64_t));
+      offsets.clear();
+    }
+  }
+
+  out.seek(h.targets);
+  for(vertID v=0; v<n; ++v) {
+    for(unsigned i=0; i<g.get_degree(v); ++i)
+      targets.push_back(g.get_neighbor(v, i));
+    if(targets.size() >= BLOCK || v+1 == n) {
+      out.write(targets.data(), targets.size() * sizeof(uint32_t));
+      targets.clear();
+    }
+  }
+
+  out.seek(h.weights);
+  for(vertID v=0; v<n; ++v) {
+    for(unsigned i=0; i<g.get_degree(v); ++i)
+      weights.push_back(g.get_neighbor_weight(v, i));
+    if(weights.size() >= BLOCK || v+1 == n) {
+      out.write(weights.data(), weights.size() * sizeof(etype));
+      weights.clear();
+    }
+  }
+  return out.close();
+}
+
+template <class vtype, class etype, class index, class storage,
+          class idtype>
+bool write_graph(const char* path,
+                 Graph<vtype,etype,index,storage,idtype>& g) {
+  return write_graph_file<vtype,etype>(path, g);
+}
+
+template <class vtype, class etype>
+bool write_graph(const char* path, CSRGraph<vtype,etype>& g) {
+  return write_graph_file<vtype,etype>(path, g);
+}
+
+// HexBoardView: a HexBoard seen through the adjacency queries of its
+// topology. With the IMPLICIT topology (the default) or the FROZEN one,
+// the graph the board derives from holds no edges, so saving it as a
+// Graph would lose them; the view asks the board for the neighbors of
+// each vertex instead (write_graph_file visits the vertices in order, so
+// it keeps those of the last vertex asked for)
+class HexBoardView {
+private:
+  HexBoard& b;
+  vertID cur;
+  vector<vertID> neigh;
+
+  const vector<vertID>& load(vertID v) {
+    if(v != cur) {
+      b.get_neighbors(v, neigh);
+      cur = v;
+    }
+    return neigh;
+  }
+
+public:
+  HexBoardView(HexBoard& hb): b(hb), cur(NO_VERTEX) {}
+
+  unsigned get_nodes() { return b.get_nodes(); }
+  Color get_vertex_key(vertID v) { return b.get_vertex_key(v); }
+  unsigned get_degree(vertID v) { return load(v).size(); }
+  vertID get_neighbor(vertID v, unsigned i) { return load(v)[i]; }
+  NoWeight get_neighbor_weight(vertID, unsigned) { return NoWeight(); }
+};
+
+inline bool write_graph(const char* path, HexBoard& b) {
+  HexBoardView view(b);
+  return write_graph_file<Color,NoWeight>(path, view);
+}
+
+// MappedGraph: a read-only graph that lives in a mapped graph file
+template <class vtype, class etype>
+class MappedGraph {
+private:
+  void* base; // start of the mapping (0 if closed)
+  size_t length; // size of the mapping
+  uint64_t nodes, arcs;
+  const vtype* keys;
+  const uint64_t* offsets;
+  const uint32_t* targets;
+  const etype* weights;
+
+  MappedGraph(const MappedGraph&); // no copies
+  MappedGraph& operator=(const MappedGraph&);
+
+  // position of the edge (x,y) in targets, or -1 if not found
+  int64_t find(vertID x, vertID y) const {
+    for(uint64_t i=offsets[x]; i<offsets[x+1]; ++i)
+      if(targets[i] == y)
+        return static_cast<int64_t>(i);
+    return -1;
+  }
+
+public:
+  MappedGraph(): base(0), length(0), nodes(0), arcs(0) {}
+
+  // maps the graph file at 'path'; returns false if it can't be read or
+  // was not written with these types
+  bool open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if(fd < 0)
+      return false;
+    struct stat st;
+    if(fstat(fd, &st) != 0 ||
+       static_cast<size_t>(st.st_size) < sizeof(GraphFileHeader)) {
+      ::close(fd);
+      return false;
+    }
+
+    length = st.st_size;
+    base = mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping stays valid
+    if(base == MAP_FAILED) {
+      base = 0;
+      return false;
+    }
+
+    // check that the header is ours and that every section fits
+    const GraphFileHeader* h = static_cast<const GraphFileHeader*>(base);
+    GraphFileHeader expect = make_graphfile_header<vtype,etype>(h->nodes,
+                                                                h->arcs);
+    if(memcmp(h->magic, "HEXG", 4) != 0 || h->version != GRAPHFILE_VERSION ||
+       h->key_size != sizeof(vtype) || h->weight_size != sizeof(etype) ||
+       h->keys != expect.keys || h->offsets != expect.offsets ||
+       h->targets != expect.targets || h->weights != expect.weights ||
+       h->nodes >= NO_VERTEX ||
+       h->weights + h->arcs * sizeof(etype) > length) {
+      close();
+      return false;
+    }
+
+    const char* p = static_cast<const char*>(base);
+    nodes = h->nodes;
+    arcs = h->arcs;
+    keys = reinterpret_cast<const vtype*>(p + h->keys);
+    offsets = reinterpret_cast<const uint64_t*>(p + h->offsets);
+    targets = reinterpret_cast<const uint32_t*>(p + h->targets);
+    weights = reinterpret_cast<const etype*>(p + h->weights);
+    if(offsets[nodes] != arcs) {
+      close();
+      return false;
+    }
+    return true;
+  }
+
+  void close() {
+    if(base)
+      munmap(base, length);
+    base = 0;
+    length = 0;
+    nodes = arcs = 0;
+  }
+
+  bool is_open() const { return base != 0; }
+
+  // acessor methods (same as CSRGraph)
+  unsigned get_nodes() const { return nodes; }
+  unsigned get_edges() const { return arcs / 2; }
+  bool is_vertex(vertID x) const { return x < nodes; }
+  unsigned get_degree(vertID v) const { return offsets[v+1] - offsets[v]; }
+  vertID get_neighbor(vertID v, unsigned i) const {
+    return targets[offsets[v]+i];
+  }
+  etype get_neighbor_weight(vertID v, unsigned i) const {
+    return weights[offsets[v]+i];
+  }
+
+  // calls f(w) for every neighbor w of v (see the traversals in graph.hpp)
+  template <class F>
+  void for_each_neighbor(vertID v, F& f) const {
+    for(uint64_t i=offsets[v]; i<offsets[v+1]; ++i)
+      f(targets[i]);
+  }
+
+  ArrayRange<vertID> neighbors(vertID v) const {
+    assert(is_vertex(v));
+    return ArrayRange<vertID>(targets + offsets[v], targets + offsets[v+1]);
+  }
+  ArrayRange<etype> neighbor_weights(vertID v) const {
+    assert(is_vertex(v));
+    return ArrayRange<etype>(weights + offsets[v], weights + offsets[v+1]);
+  }
+
+  bool is_adjacent(vertID x, vertID y) const {
+    assert(is_vertex(x) && is_vertex(y));
+    return find(x, y) >= 0;
+  }
+
+  etype get_edge_weight(vertID x, vertID y) const {
+    int64_t i = find(x, y);
+    assert(i >= 0);
+    return weights[i];
+  }
+
+  vtype get_vertex_key(vertID x) const {
+    assert(is_vertex(x));
+    return keys[x];
+  }
+
+  ~MappedGraph() { close(); }
+};
+
+// replaces the contents of g with the graph saved at 'path'; returns false
+// if the file can't be mapped
+template <class vtype, class etype, class index, class storage,
+          class idtype>
+bool load_graph(const char* path,
+                Graph<vtype,etype,index,storage,idtype>& g) {
+  MappedGraph<vtype,etype> m;
+  if(!m.open(path))
+    return false;
+
+  g.clear();
+  for(vertID v=0; v<m.get_nodes(); ++v)
+    g.add_vertex(m.get_vertex_key(v));
+  for(vertID v=0; v<m.get_nodes(); ++v) {
+    for(unsigned i=0; i<m.get_degree(v); ++i) {
+      vertID u = m.get_neighbor(v, i);
+      if(v < u)
+        g.add_edge(v, u, m.get_neighbor_weight(v, i));
+    }
+  }
+  return true;
+}
+#endif
@@ -9,6 +9,7 @@
 #include "cursor.hpp"
 #include "player.hpp"
 #include "aiplayer.hpp"
+#include "mctsplayer.hpp"
 using namespace std;
 
 // select player types
@@ -17,28 +18,35 @@ void select_players(HexBoard &board, Player* &p1, Player* &p2) {
        << "1 - Computer(X) vs (O)Human" << endl
        << "2 -    Human(X) vs (O)Computer" << endl
        << "3 -    Human(X) vs (O)Human" << endl
-       << "4 - Computer(X) vs (O)Computer" << endl;
+       << "4 - Computer(X) vs (O)Computer" << endl
+       << "5 -     MCTS(X) vs (O)Human" << endl
+       << "6 -    Human(X) vs (O)MCTS" << endl
+       << "7 -     MCTS(X) vs (O)Computer" << endl;
 
   Cursor cur;
   int code;
   while(true) {
     code = static_cast<int>(cur.read()) - static_cast<int>('0');
-    if(code >= 1 && code <= 4)
+    if(code >= 1 && code <= 7)
       break;
   }
 
   // selecting player1
   if(code == 1 || code == 4) {
     p1 = new AIMonteCarloPlayer("Player1",&board);
-    //static_cast<AIMonteCarloPlayer*>(p1)->set_trials(100);
+    //static_cast<AIMonteCarloPlayer*>(p1)->set_budget(10000);
+  } else if(code == 5 || code == 7) {
+    p1 = new AIMCTSPlayer("Player1",&board);
   } else {
     p1 = new ArrowHumanPlayer("Player1", &board);
   }
 
   // selecting player2
-  if(code == 2 || code == 4) {
+  if(code == 2 || code == 4 || code == 7) {
     p2 = new AIMonteCarloPlayer("Player2",&board);
-    //static_cast<AIMonteCarloPlayer*>(p2)->set_trials(100);
+    //static_cast<AIMonteCarloPlayer*>(p2)->set_budget(10000);
+  } else if(code == 6) {
+    p2 = new AIMCTSPlayer("Player2",&board);
   } else {
     p2 = new ArrowHumanPlayer("Player2", &board);
   }
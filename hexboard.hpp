@@ -21,7 +21,13 @@
 #include <iomanip> // setw
 #include <cstdlib> // system("clear")
 #include <cassert> // assert
+#include <memory> // shared_ptr
+#include <type_traits> // is_nothrow_move_constructible
 #include "graph.hpp"
+#include "bitboard.hpp"
+#include "disjointset.hpp"
+#include "hextopology.hpp"
+#include "csrgraph.hpp"
 using namespace std;
 
 // Blue: vertex taken by player1 or player1's margin (wall)
@@ -61,6 +67,18 @@ ostream& operator<<
   return out;
 }
 
+// backends used to decide victory:
+// GRAPH = color-aware depth-first search over the graph
+// BITBOARD = bit-parallel flood fill over packed stones (up to BB_MAX_DIM;
+// larger boards always use GRAPH)
+enum class Backend: int {GRAPH, BITBOARD};
+
+// sources of adjacency information:
+// EXPLICIT = edges stored in the graph (one edge list per vertex)
+// IMPLICIT = neighbors computed arithmetically by HexTopology (no edges)
+// FROZEN = edges built once and frozen into a CSRGraph (contiguous arrays)
+enum class Topology: int {EXPLICIT, IMPLICIT, FROZEN};
+
 // transpose is a functor that converts an x,y coordinate into one index of
 // graph vertex i. The conversion may use different limits and there may or not
 // be an (x,y) offset involved.
@@ -83,8 +101,105 @@ public:
   }
 };
 
+// HexPosition: the state of a game that changes from move to move: the
+// stones of both players (as a BitBoard), the side to move and the
+// Zobrist hash.  Everything that depends only on the board size lives in
+// a HexTopology, which every method receives as a parameter; therefore
+// a position is a small plain value that can be copied with memcpy and
+// we can keep thousands of them around (scratch boards, search nodes,
+// concurrent games).
+
+class HexPosition {
+private:
+  BitBoard stones; // stones on the playable area (walls are implicit)
+  bool p1_turn; // it's either player1's turn(true) or player2's turn(false)
+  uint64_t hash; // Zobrist hash of the stones (walls included) and turn
+
+  // index of the player that owns 'sym' in the bitboard
+  static int player(Color sym) { return (sym == Color::BLUE ? 0 : 1); }
+
+public:
+  HexPosition(): p1_turn(true), hash(0) {}
+  HexPosition(const HexTopology& t) { reset(t); }
+
+  // empty board, player1 to move
+  void reset(const HexTopology& t) {
+    stones.clear();
+    p1_turn = true;
+    hash = t.get_wall_hash();
+  }
+
+  // returns the color of playable vertex v (WHITE if empty)
+  Color get_stone(vertID v) const {
+    switch(stones.owner(v)) {
+      case 0: return Color::BLUE;
+      case 1: return Color::RED;
+      default: return Color::WHITE;
+    }
+  }
+
+  // places a stone of color 'key' on playable vertex v (WHITE removes it)
+  void set_stone(const HexTopology& t, vertID v, Color key) {
+    const ZobristTable& z = t.get_zobrist();
+    int old = stones.owner(v);
+    if(old >= 0)
+      hash ^= z.stone(v, old);
+
+    if(key == Color::BLUE || key == Color::RED) {
+      stones.set(v, player(key));
+      hash ^= z.stone(v, player(key));
+    } else {
+      stones.clear(v);
+    }
+  }
+
+  // gives the turn to the other player
+  void pass_turn(const HexTopology& t) {
+    p1_turn = !p1_turn;
+    hash ^= t.get_zobrist().get_side();
+  }
+
+  // return information about the current player
+  bool is_p1_turn() const { return p1_turn; }
+  Color get_current_player_symbol() const {
+    return (p1_turn ? Color::BLUE : Color::RED);
+  }
+
+  // updates only the hash for a stone of color 'key' placed on or removed
+  // from v (for boards larger than BB_MAX_DIM, whose positions keep the
+  // turn and the hash but no stones)
+  void toggle_hash(const HexTopology& t, vertID v, Color key) {
+    hash ^= t.get_zobrist().stone(v, player(key));
+  }
+
+  uint64_t get_hash() const { return hash; }
+  const BitBoard& get_stones() const { return stones; }
+
+  // empty playable vertices, as a bitset or as a list of vertex IDs (in
+  // increasing order), and how many there are
+  BitSet get_empty(const HexTopology& t) const {
+    return t.get_masks().get_empty(stones);
+  }
+  void get_empty(const HexTopology& t, vector<vertID>& out) const {
+    out.clear();
+    get_empty(t).get_bits(out);
+  }
+  unsigned count_empty(const HexTopology& t) const {
+    return t.get_masks().count_empty(stones);
+  }
+
+  // determines if the player with color 'sym' has connected its walls
+  bool is_victory(const HexTopology& t, Color sym) const {
+    return t.get_masks().is_victory(stones, player(sym));
+  }
+
+  bool operator==(const HexPosition& o) const {
+    return p1_turn == o.p1_turn && stones == o.stones;
+  }
+};
+
 // HexBoard:  in this  design, a  Hex board  is a  graph with  'color'
-// vertex  labels  and  integer  weights.   The  idea  is  to  find  a
+// vertex  labels  and  unweighted edges.   The  idea  is  to  find  a
 // color-aware  MST  at every  player  move  to  find a  path  between
 // opposing walls  belonging to  the current  player. For  example, if
 // there  is a  Red  MST,  player1 wins.   I  will add  interconnected
@@ -103,7 +218,56 @@ public:
 // Dijkstra  in this  case, because  we simply  look for  a path,  not
 // necessarily the shortest one.
 
-class HexBoard: public Graph<Color,int> {
+// Since the DFS dominates the cost of every Monte Carlo playout, the
+// board also mirrors its stones  into a HexPosition (one bitset per
+// player, plus the  side to move and the hash)  and, by default, decides
+// victory with a bit-parallel flood fill. The DFS remains available
+// through the GRAPH backend (it runs on the generic traversals of
+// graph.hpp, with a workspace owned by the board, so it doesn't
+// allocate). Boards larger than BB_MAX_DIM, the largest size supported
+// by the bitboards, don't mirror their stones: they always use the GRAPH
+// backend, list their free positions by scanning the graph, and keep only
+// the side to move and the hash in their position (so get_position and
+// set_position, and the players built on them, need a bitboard size).
+
+// The parts of the board that never change (adjacency, bitboard masks,
+// Zobrist keys) are kept in a HexTopology that may be shared with other
+// boards and positions of the same size.
+
+// The outcome of play() does not need any search at all: the board keeps
+// a disjoint-set structure over the stones and the four walls (each wall
+// starts as a single set). Placing a stone merges it with at most six
+// neighboring sets of the same color, and a player has won as soon as
+// both of its walls fall into the same set. The structure supports
+// rollback, so moves can later be retracted cheaply.
+
+// The  adjacency of a hex grid  is a fixed pattern,  so by default the
+// board does not store edges at all (IMPLICIT topology): HexTopology
+// computes the six neighbors of a vertex from its row and column. The
+// EXPLICIT topology inserts every edge into the graph, as before, and
+// the FROZEN topology builds the same edges once and moves them into a
+// CSRGraph. The edge lists of the graph live in an arena (ArenaStorage)
+// that reset_board recycles, so new games don't allocate them again.
+// All adjacency queries of the board go through the selected topology.
+
+// Every position has a 64-bit Zobrist hash (see zobrist.hpp), updated
+// with one XOR whenever a vertex changes color and whenever the turn
+// passes to the other player (the walls never change after reset_board,
+// so they add the same constant to every hash of a given board size).
+
+// Moves made with play() are recorded on a stack, so that search code can
+// retract them with undo() in  constant time: we restore the color of the
+// vertex, the side to move (and thus the hash), and roll the groups back
+// to their state before the move. Editing vertices directly through
+// set_vertex_key is not recorded; it leaves the groups stale, and undo
+// then simply keeps them stale until the next play rebuilds them.
+
+// the graph of the board keeps all its edge lists in one arena, recycled by
+// every reset_board; its edges are unweighted and its vertex IDs fit in 16
+// bits (BB_MAX_CELLS), so each edge is 2 bytes
+typedef Graph<Color,NoWeight,ScanIndex,ArenaStorage,uint16_t> BoardGraph;
+
+class HexBoard: public BoardGraph {
 private:
   // dimension of the square hex board with margins (visible+invisible)
   vertID abs_dim;
@@ -116,25 +280,92 @@ private:
   // rel_pos: for displaying the visible part of the board 
   Transpose rel_pos;
 
-  bool p1_turn; // it's either player1's turn(true) or player2's turn(false)
+  // size-dependent data shared with other boards, and the current
+  // position (stones, side to move and hash)
+  shared_ptr<const HexTopology> topo;
+  HexPosition pos;
+
+  // information needed to retract one move
+  struct Move {
+    vertID vert; // vertex that received the stone
+    bool p1_turn; // side to move before the move
+    size_t groups_mark; // checkpoint of the groups before the move
+    unsigned groups_epoch; // rebuild the checkpoint refers to
+  };
+  vector<Move> moves; // moves that can be undone (most recent last)
+
+  // algorithm used by is_victory
+  Backend backend;
+
+  // where the adjacency comes from (HexTopology computes it) and its frozen
+  // version
+  Topology topology;
+  CSRGraph<Color,NoWeight> frozen;
+
+  // groups of connected stones of the same color (walls included); when
+  // vertices are modified directly via set_vertex_key, the groups are
+  // marked as stale and rebuilt on the next call to play
+  RollbackDisjointSets groups;
+  bool groups_stale;
+  // incremented by every rebuild (older checkpoints become useless)
+  unsigned groups_epoch;
 
   //void print(ostream& out) { print(out, abs_pos, abs_dim); }; // debug
   void print(ostream& out) { print(out, rel_pos, rel_dim); }; // game mode
   void print(ostream& out, Transpose& pos, vertID dim);
 
+  // depth-first search version of is_victory (GRAPH backend)
+  bool is_victory_dfs(Color sym);
+  // reused by every search, so is_victory_dfs doesn't allocate
+  TraversalWorkspace search;
+
+  // VictoryVisitor: follows stones of one color and stops at dst
+  struct VictoryVisitor {
+    HexBoard& b;
+    Color sym;
+    vertID dst;
+
+    VictoryVisitor(HexBoard& hb, Color s, vertID d): b(hb), sym(s), dst(d) {}
+    bool follow(vertID, vertID to) { return b.get_vertex_key(to) == sym; }
+    bool discover(vertID v) { return v == dst; }
+  };
+
+  // fills 'out' with the neighbors of v (returns how many there are)
+  unsigned neighbors(vertID v, vertID out[HEX_DEGREE]);
+
+  // updates the color of vertex x in the graph and in the position
+  void paint(vertID x, Color key);
+  // merges the stone at x with its neighbors of the same color
+  void connect_stone(vertID x);
+  // recomputes all groups from scratch
+  void rebuild_groups();
+  // determines if both walls of 'sym' belong to the same group
+  bool is_connected(Color sym);
+
 public:
-  HexBoard(unsigned dim): 
+  HexBoard(unsigned dim, Backend be = Backend::BITBOARD,
+           Topology tp = Topology::IMPLICIT):
+    HexBoard(make_shared<HexTopology>(dim), be, tp) {}
+
+  // builds a board that shares the (immutable) topology t
+  HexBoard(shared_ptr<const HexTopology> t, Backend be = Backend::BITBOARD,
+           Topology tp = Topology::IMPLICIT): 
     // initializes the dimensions excluding/including margins
-    rel_dim(static_cast<vertID>(dim)),  // excludes margins
-    abs_dim(static_cast<vertID>(dim+2)),// includes margins
+    rel_dim(t->get_playable_dim()),  // excludes margins
+    abs_dim(t->get_dim()),// includes margins
     // intitializes the functors for printing
     // abs_pos: converts x,y into a graph vertex index including the margins
-    abs_pos(Transpose(0,0,static_cast<vertID>(dim+2))), 
+    abs_pos(Transpose(0,0,t->get_dim())), 
     // rel_pos: converts x,y into a graph vertex index excluding the margins
-    rel_pos(Transpose(1,1,static_cast<vertID>(dim+2))),
-    p1_turn(true) { // start with player1
+    rel_pos(Transpose(1,1,t->get_dim())),
+    topo(t),
+    backend(be),
+    topology(tp),
+    groups_stale(true),
+    groups_epoch(0) {
     // validate parameters and build graph
     assert(rel_dim > 2);
+    set_backend(be);
     reset_board();
   }
 
@@ -148,29 +379,86 @@ public:
   void reset_board();
   // tries to play a move
   Outcome play(int row, int col);
+  // tries to play a move, addressing the position by its vertex ID
+  Outcome play_vertex(vertID v);
+  // retracts the last move made with play/play_vertex
+  void undo();
+  // number of moves that can be undone
+  unsigned get_move_count() { return moves.size(); }
   // return information about the current player
-  int get_current_player() { return (p1_turn ? 1 : 2); }
+  int get_current_player() { return (pos.is_p1_turn() ? 1 : 2); }
   Color get_current_player_symbol() { 
-    return (p1_turn ? Color::BLUE : Color::RED); 
+    return pos.get_current_player_symbol();
   }
+  // returns the Zobrist hash of the position (stones and side to move)
+  uint64_t get_hash() { return pos.get_hash(); }
+  // returns the current position (a copy is a cheap snapshot of the game)
+  const HexPosition& get_position() {
+    assert(topo->has_bitboard());
+    return pos;
+  }
+  // returns the size-dependent data of this board (shareable)
+  const shared_ptr<const HexTopology>& get_hex_topology() { return topo; }
 
   // returns the dimension of the playable area of the board
   int get_playable_dim() { return static_cast<int>(rel_dim); }
-  // fills the free vector with all blank positions on the board 
+  // fills the free vector with all blank positions on the board (read
+  // from the bitboards of the position)
   void get_free_vertices(vector<vertID>& fvert);
+  // returns the number of blank positions on the board
+  unsigned count_free_vertices();
   // translates a vertex number into a row,col coordinate
   void vertex_to_row_col(vertID vert, int& row, int& col);
   // copies over the state of all vertices
   void clone_board_state(HexBoard& other);
+  // replaces the stones and the side to move by those of position p
+  // (and starts a new move list: the old moves can't be undone)
+  void set_position(const HexPosition& p);
   // determines if the player with color 'sym' has won
   bool is_victory(Color sym);
+  // modifies the color of a vertex (keeps the position in sync, but the
+  // groups used by play are rebuilt on the next move)
+  void set_vertex_key(vertID x, Color key);
+
+  // adjacency queries answered by the selected topology
+  bool is_adjacent(vertID x, vertID y);
+  void get_neighbors(vertID v, vector<vertID>& neigh);
+  Topology get_topology() { return topology; }
+
+  // calls f(w) for every neighbor w of v (lets the traversals of graph.hpp
+  // run on the board, whatever its topology)
+  template <class F>
+  void for_each_neighbor(vertID v, F& f) {
+    vertID neigh[HEX_DEGREE];
+    unsigned n = neighbors(v, neigh);
+    for(unsigned i=0; i<n; ++i)
+      f(neigh[i]);
+  }
+
+  // selects the algorithm used by is_victory
+  void set_backend(Backend be);
+  Backend get_backend() { return backend; }
 
-  ~HexBoard() { clear(); }
+  // copies are independent boards that share the topology; with the
+  // IMPLICIT topology there are no edges, so a copy is little more than
+  // the vertex colors, the position and the move stack
+  HexBoard(const HexBoard& b) = default;
+  HexBoard& operator=(const HexBoard& b) = default;
+  HexBoard(HexBoard&& b) noexcept = default;
+  HexBoard& operator=(HexBoard&& b) noexcept = default;
+
+  // returns an independent copy of this board (moves can still be undone)
+  HexBoard clone() { return *this; }
 };
 
+static_assert(is_nothrow_move_constructible<HexBoard>::value,
+              "HexBoard moves must not throw");
+
 // builds a new board ready to begin playing
 void HexBoard::reset_board() {
   clear(); // if there was anything in the graph, remove it
+  pos.reset(*topo); // empty board, player1 to move
+  moves.clear();
 
   // add all vertices (including margins) initially as white 
   for(vertID i=0; i<(abs_dim * abs_dim); ++i) 
@@ -193,8 +481,9 @@ void HexBoard::reset_board() {
     set_vertex_key(abs_pos(abs_dim-1,abs_dim-1),Color::GRAY);
   }
 
-  // add the edges of the left, right, and bottom margins
-  for(vertID row=0; row<abs_dim; ++row) {
+  // add the edges of the left, right, and bottom margins (only when the
+  // adjacency is stored in the graph)
+  for(vertID row=0; topology!=Topology::IMPLICIT && row<abs_dim; ++row) {
     for(vertID col=0; col<abs_dim; ++col) {
       // horizontal edges
       if(col<abs_dim-1) 
@@ -216,7 +505,14 @@ void HexBoard::reset_board() {
       add_edge(abs_pos(row,abs_dim-1), abs_pos(row+1,abs_dim-1), 1);
   }
 
-  p1_turn = true; // we always begin with player 1
+  // the topology never changes after this point: freeze it into CSR form
+  // and drop the per-vertex edge lists
+  if(topology == Topology::FROZEN) {
+    frozen.build(*this);
+    clear_edges();
+  }
+
+  rebuild_groups(); // one group per wall
 }
 
 // prints the complete graph or the visible board, depending on the
@@ -272,33 +568,80 @@ Outcome HexBoard::play(int rowi, int coli) {
   if(!(row>=0 && col>=0 && row<rel_dim && col<rel_dim))
     return Outcome::OOB_ERROR; // illegal move: out-of-bounds
 
-  if(get_vertex_key(rel_pos(row,col)) != Color::WHITE)
+  return play_vertex(rel_pos(row,col));
+}
+
+// same as play, for a vertex ID (as returned by get_free_vertices); the move
+// is recorded so that it can be undone
+Outcome HexBoard::play_vertex(vertID v) {
+  // margins are never white, so one test covers the common case
+  if(!is_vertex(v) || get_vertex_key(v) != Color::WHITE) {
+    if(!is_vertex(v) || !topo->is_playable(v))
+      return Outcome::OOB_ERROR; // illegal move: out-of-bounds
     return Outcome::OCC_ERROR; // illegal move: position occupied
+  }
 
-  // legal move: search for victory
-  set_vertex_key(rel_pos(row,col), (p1_turn ? Color::BLUE : Color::RED));
-  // checks if the last player to play has won (denoted by p1_turn)
-  if(is_victory(get_current_player_symbol()))
-    return (p1_turn ? Outcome::P1_WIN : Outcome::P2_WIN);
+  // legal move: merge the new stone with its neighbors
+  if(groups_stale)
+    rebuild_groups();
+  Move m = {v, pos.is_p1_turn(), groups.mark(), groups_epoch};
+  moves.push_back(m);
+  paint(v, get_current_player_symbol());
+  connect_stone(v);
+  // checks if the last player to play has won (denoted by the turn)
+  if(is_connected(get_current_player_symbol()))
+    return (pos.is_p1_turn() ? Outcome::P1_WIN : Outcome::P2_WIN);
 
   // switch to opposite player
-  p1_turn = !p1_turn; 
+  pos.pass_turn(*topo);
 
   return Outcome::NO_WIN; // legal move, no winner
 }
 
+// retracts the last move: clears its vertex, gives the turn back to the
+// player who made it and undoes its unions
+void HexBoard::undo() {
+  assert(!moves.empty());
+  Move m = moves.back();
+  moves.pop_back();
+
+  paint(m.vert, Color::WHITE);
+  if(!groups_stale && m.groups_epoch == groups_epoch)
+    groups.rollback(m.groups_mark);
+  else
+    groups_stale = true; // the groups were rebuilt (or edited) since
+
+  if(pos.is_p1_turn() != m.p1_turn)
+    pos.pass_turn(*topo);
+}
+
 // returns a list of free board positions (as graph vertices)
 void HexBoard::get_free_vertices(vector<vertID>& fvert) {
-  // removes any items from the list of free positions
+  // the position mirrors every stone, so the free positions are the
+  // playable bits without a stone (in the same row-major order as a scan
+  // of the board)
+  if(topo->has_bitboard()) {
+    pos.get_empty(*topo, fvert);
+    return;
+  }
+
   fvert.clear();
-  
-  // searches the list of playable positions for free positions
-  for(vertID row=0; row<rel_dim; ++row) {
-    for(vertID col=0; col<rel_dim; ++col) {
-      if(get_vertex_key((rel_pos(row,col))) == Color::WHITE)
+  for(vertID row=0; row<rel_dim; ++row)
+    for(vertID col=0; col<rel_dim; ++col)
+      if(get_vertex_key(rel_pos(row,col)) == Color::WHITE)
         fvert.push_back(rel_pos(row,col));
-    }
-  }
+}
+
+// returns the number of blank positions on the board
+unsigned HexBoard::count_free_vertices() {
+  if(topo->has_bitboard())
+    return pos.count_empty(*topo);
+
+  unsigned n = 0;
+  for(vertID row=0; row<rel_dim; ++row)
+    for(vertID col=0; col<rel_dim; ++col)
+      n += (get_vertex_key(rel_pos(row,col)) == Color::WHITE);
+  return n;
 }
 
 // translates from vertex ID into a row and col coordinate
@@ -315,11 +658,132 @@ void HexBoard::clone_board_state(HexBoard& other) {
     set_vertex_key(i, other.get_vertex_key(i));
     //cout << static_cast<int>(get_vertex_key(i)) << " ";
   }
+
+  // the side to move is part of the state (and of the hash)
+  if(pos.is_p1_turn() != other.pos.is_p1_turn())
+    pos.pass_turn(*topo);
+}
+
+// loads position p (of the same size): its stones and its side to move
+void HexBoard::set_position(const HexPosition& p) {
+  assert(topo->has_bitboard());
+  for(vertID row=0; row<rel_dim; ++row)
+    for(vertID col=0; col<rel_dim; ++col)
+      paint(rel_pos(row,col), p.get_stone(rel_pos(row,col)));
+
+  if(pos.is_p1_turn() != p.is_p1_turn())
+    pos.pass_turn(*topo);
+  moves.clear(); // they were played on another position
+  groups_stale = true;
+}
+
+// modifies the color of vertex x; the groups no longer reflect the board
+void HexBoard::set_vertex_key(vertID x, Color key) {
+  paint(x, key);
+  groups_stale = true;
+}
+
+// modifies the color of vertex x; stones on the playable area are mirrored
+// into the position (margins are implicit there)
+void HexBoard::paint(vertID x, Color key) {
+  if(topo->is_playable(x)) {
+    if(topo->has_bitboard()) {
+      pos.set_stone(*topo, x, key);
+    } else {
+      // no bitboard: only the hash follows the stones
+      Color old = get_vertex_key(x);
+      if(old == Color::BLUE || old == Color::RED)
+        pos.toggle_hash(*topo, x, old);
+      if(key == Color::BLUE || key == Color::RED)
+        pos.toggle_hash(*topo, x, key);
+    }
+  }
+  BoardGraph::set_vertex_key(x, key);
+}
+
+// switches the victory algorithm (boards without a bitboard stay on GRAPH)
+void HexBoard::set_backend(Backend be) {
+  backend = topo->has_bitboard() ? be : Backend::GRAPH;
+}
+
+// determines if the player with color 'sym' has a path between its walls
+bool HexBoard::is_victory(Color sym) {
+  if(backend == Backend::BITBOARD)
+    return pos.is_victory(*topo, sym);
+  return is_victory_dfs(sym);
+}
+
+// merges the stone (or wall vertex) at x with the groups of its neighbors
+// of the same color
+void HexBoard::connect_stone(vertID x) {
+  Color key = get_vertex_key(x);
+  vertID neigh[HEX_DEGREE];
+  unsigned n = neighbors(x, neigh);
+  for(unsigned i=0; i<n; ++i) {
+    if(get_vertex_key(neigh[i]) == key)
+      groups.unite(x, neigh[i]);
+  }
+}
+
+// recomputes the groups from the colors of the board: each wall becomes a
+// single group, and so does each chain of adjacent stones of the same color
+void HexBoard::rebuild_groups() {
+  groups.reset(get_nodes());
+  for(vertID i=0; i<get_nodes(); ++i) {
+    Color key = get_vertex_key(i);
+    if(key == Color::BLUE || key == Color::RED)
+      connect_stone(i);
+  }
+  groups_stale = false;
+  groups_epoch++;
+}
+
+// fills 'out' with the neighbors of v, either computed or read from the graph
+unsigned HexBoard::neighbors(vertID v, vertID out[HEX_DEGREE]) {
+  if(topology == Topology::IMPLICIT)
+    return topo->neighbors(v, out);
+
+  if(topology == Topology::FROZEN) {
+    ArrayRange<vertID> r = frozen.neighbors(v);
+    assert(r.size() <= HEX_DEGREE);
+    for(unsigned i=0; i<r.size(); ++i)
+      out[i] = r[i];
+    return r.size();
+  }
+
+  unsigned n = get_degree(v);
+  assert(n <= HEX_DEGREE);
+  for(unsigned i=0; i<n; ++i)
+    out[i] = get_neighbor(v, i);
+  return n;
+}
+
+// verifies if x and y are neighbors on the board
+bool HexBoard::is_adjacent(vertID x, vertID y) {
+  if(topology == Topology::IMPLICIT)
+    return topo->is_adjacent(x, y);
+  if(topology == Topology::FROZEN)
+    return frozen.is_adjacent(x, y);
+  return BoardGraph::is_adjacent(x, y);
+}
+
+// returns the neighbors of v in vector neigh
+void HexBoard::get_neighbors(vertID v, vector<vertID>& neigh) {
+  vertID tmp[HEX_DEGREE];
+  unsigned n = neighbors(v, tmp);
+  neigh.assign(tmp, tmp+n);
+}
+
+// a player wins when both of its walls are in the same group
+bool HexBoard::is_connected(Color sym) {
+  if(sym == Color::BLUE)
+    return groups.same(abs_pos(1,0), abs_pos(1,abs_dim-1));
+  return groups.same(abs_pos(0,1), abs_pos(abs_dim-1,1));
 }
 
 // Using a color-aware depth-first search, determine if there is a path across
 // the board, using the color of the player under evaluation.
-bool HexBoard::is_victory(Color sym) {
+bool HexBoard::is_victory_dfs(Color sym) {
   // find src and dst for the path of victory (if it exists)
   vertID src, dst;
   if(sym == Color::BLUE) {
@@ -330,47 +794,10 @@ bool HexBoard::is_victory(Color sym) {
     dst = abs_pos(abs_dim-1,abs_dim-2); // matching bottom-right margin
   }
 
-  // keep track of visited nodes
-  vector<bool> visited(get_nodes(), false);
-  // implement a stack in a vector
-  vector<vertID> stack;
-  stack.push_back(src);
-  // list of neighbors of cur (top of stack)
-  vector<vertID> neigh;
-  vertID top;
-
-  while(!stack.empty()) {
-    // get top of the stack
-    top = stack.back();
-    stack.pop_back();
-
-    // find all neighbors of top of the stack
-    get_neighbors(top, neigh);
-    // check if we found dst or push neighbor
-    for(auto p=neigh.begin(); p!=neigh.end(); ++p) {
-      // have we found the destination node?
-      if(*p == dst) {
-        stack.clear();
-        neigh.clear();
-        visited.clear();
-        return true;
-      }
-
-      // we haven't found dst yet, look at unvisited neighbors of the same
-      // color.
-      if(!visited[*p]) {
-        visited[*p] = true;
-        if(get_vertex_key(*p) == sym)
-          stack.push_back(*p);
-      }
-    }
-
-    neigh.clear();
-  }
-
-  // dst not found, we didn't win
-  visited.clear();
-  return false;
+  // walk over the stones of color sym, starting at src, until we reach dst
+  // (the walls of sym have color sym too)
+  VictoryVisitor vis(*this, sym, dst);
+  return dfs(*this, src, search, vis);
 }
 
 #if 0
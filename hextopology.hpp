@@ -0,0 +1,116 @@
+// -------------------------------------------------------------------
+// hextopology.hpp
+//
+// HexTopology: the  adjacency of a Hex  board computed arithmetically.
+// On a row-major dim x dim grid (margins included), the neighbors of
+// vertex v=(r,c) are always the same six offsets:
+//
+//     (r-1,c) (r-1,c+1)            v-dim   v-dim+1
+//   (r,c-1)  v  (r,c+1)    =>   v-1    v    v+1
+//     (r+1,c-1) (r+1,c)            v+dim-1 v+dim
+//
+// minus the ones  that fall outside the grid. This is  exactly the set
+// of edges that HexBoard::reset_board inserts into the graph, so we can
+// answer neighbor and adjacency queries without storing any edges.
+
+// A HexTopology also owns everything else that depends only on the size
+// of the board: the bitboard masks and the Zobrist keys. It never changes
+// after construction, so one instance can be shared (via shared_ptr) by
+// any number of boards and positions of the same size. Boards larger than
+// BB_MAX_DIM have no bitboard masks (the Zobrist keys and the adjacency
+// don't depend on the bitboards, so they work at any size).
+// author: Luiz Ramos
+
+#ifndef HEXTOPOLOGY_HPP
+#define HEXTOPOLOGY_HPP
+
+#include <cstdint> // uint64_t
+#include "graph.hpp"
+#include "bitboard.hpp"
+#include "zobrist.hpp"
+using namespace std;
+
+// maximum number of neighbors of any vertex of a hex grid
+const unsigned HEX_DEGREE = 6;
+
+class HexTopology {
+private:
+  vertID dim; // dimension of the grid (margins included)
+  vertID rel_dim; // dimension of the playable area (margins excluded)
+
+  BitMasks masks; // geometry of the bitboards of this size
+  ZobristTable zobrist; // keys used to hash positions of this size
+  uint64_t wall_hash; // hash of the walls (the empty board)
+
+public:
+  HexTopology(unsigned playable_dim):
+    dim(static_cast<vertID>(playable_dim+2)),
+    rel_dim(static_cast<vertID>(playable_dim)) {
+    if(has_bitboard())
+      masks.reset(rel_dim);
+    zobrist.reset(get_nodes());
+
+    // the walls are stones that never move: left/right belong to player 0
+    // and top/bottom to player 1 (corners belong to neither)
+    wall_hash = 0;
+    for(vertID i=1; i<=rel_dim; ++i) {
+      wall_hash ^= zobrist.stone(i*dim, 0) ^ zobrist.stone(i*dim+dim-1, 0);
+      wall_hash ^= zobrist.stone(i, 1) ^ zobrist.stone((dim-1)*dim+i, 1);
+    }
+  }
+
+  vertID get_dim() const { return dim; }
+  vertID get_playable_dim() const { return rel_dim; }
+  unsigned get_nodes() const { return dim * dim; }
+
+  // converts a (row,col) coordinate of the playable area into a vertex ID
+  vertID vertex(vertID row, vertID col) const {
+    return (row+1)*dim + (col+1);
+  }
+
+  // determines if the stones of this size fit in a BitBoard
+  bool has_bitboard() const { return rel_dim <= BB_MAX_DIM; }
+
+  // verifies if x is part of the visible (playable) board
+  bool is_playable(vertID x) const {
+    if(has_bitboard())
+      return masks.is_playable(x);
+    vertID row = x / dim, col = x % dim;
+    return row >= 1 && row <= rel_dim && col >= 1 && col <= rel_dim;
+  }
+
+  const BitMasks& get_masks() const { return masks; }
+  const ZobristTable& get_zobrist() const { return zobrist; }
+  uint64_t get_wall_hash() const { return wall_hash; }
+
+  // fills 'out' with the neighbors of v and returns how many there are
+  unsigned neighbors(vertID v, vertID out[HEX_DEGREE]) const {
+    vertID row = v / dim, col = v % dim;
+    bool up = (row > 0), down = (row+1 < dim);
+    bool left = (col > 0), right = (col+1 < dim);
+    unsigned n = 0;
+
+    if(left) out[n++] = v-1;
+    if(right) out[n++] = v+1;
+    if(up) out[n++] = v-dim;
+    if(up && right) out[n++] = v-dim+1;
+    if(down) out[n++] = v+dim;
+    if(down && left) out[n++] = v+dim-1;
+    return n;
+  }
+
+  // verifies if x and y share an edge
+  bool is_adjacent(vertID x, vertID y) const {
+    if(x > y) {
+      vertID t = x; x = y; y = t;
+    }
+    // y is right of, below or below-left of x
+    vertID xr = x / dim, xc = x % dim, yr = y / dim, yc = y % dim;
+    if(yr == xr)
+      return yc == xc+1;
+    if(yr == xr+1)
+      return (yc == xc) || (yc+1 == xc);
+    return false;
+  }
+};
+#endif
@@ -0,0 +1,128 @@
+//--------------------------------------------------------------------
+// Parallel MCTS benchmark
+// author: Luiz Ramos
+
+// Runs the parallel UCT searches of mctsplayer.hpp (root-parallel: one
+// tree per thread; tree-parallel: one shared tree) on a few benchmark
+// positions with 1, 2, 4, ... threads (up to the number of cores, or the
+// given maximum), always with the same total number of playouts, and
+// reports the time, the throughput in thousands of playouts per second and
+// the speedup over one thread, together with the move chosen and its share
+// of the visits.
+//
+// The positions are the empty board, an opening (a stone in the center
+// and a reply next to it) and a middle game (a third of the board filled
+// by random moves that don't end the game).
+//
+// usage: pmcts [dim] [iterations] [max threads] [seed]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib> // atoi
+#include <chrono>
+#include <random>
+#include <thread>
+#include "hexboard.hpp"
+#include "mctsplayer.hpp"
+using namespace std;
+
+double elapsed(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// plays 'moves' random moves on b, skipping those that would end the game
+void random_moves(HexBoard& b, unsigned moves, unsigned seed) {
+  default_random_engine gen(seed);
+  vector<vertID> cells;
+  for(unsigned i=0; i<moves; ++i) {
+    b.get_free_vertices(cells);
+    shuffle(cells.begin(), cells.end(), gen);
+    for(unsigned j=0; j<cells.size(); ++j) {
+      if(b.play_vertex(cells[j]) == Outcome::NO_WIN)
+        break;
+      b.undo();
+    }
+  }
+}
+
+// searches position b with 1, 2, 4, ... threads
+template <class search_t>
+void run_search(HexBoard& b, const char* mode, unsigned iterations,
+                unsigned maxthreads, unsigned seed) {
+  search_t search(1);
+  double one = 0;
+  for(unsigned n=1; ; n *= 2) {
+    if(n > maxthreads)
+      n = maxthreads;
+    search.set_threads(n);
+
+    chrono::steady_clock::time_point t = chrono::steady_clock::now();
+    vertID move = search.search(*b.get_hex_topology(), b.get_position(),
+                                iterations, seed);
+    double secs = elapsed(t);
+    if(n == 1)
+      one = secs;
+
+    // share of the visits of the chosen move
+    const vector<unsigned>& visits = search.get_visits();
+    unsigned total = 0, chosen = 0;
+    vector<vertID> cells;
+    b.get_free_vertices(cells);
+    for(unsigned i=0; i<visits.size(); ++i) {
+      total += visits[i];
+      if(cells[i] == move)
+        chosen = visits[i];
+    }
+    int row, col;
+    b.vertex_to_row_col(move, row, col);
+
+    cout << "  " << mode << " x" << setw(3) << left << n << right << " "
+         << fixed << setprecision(3) << setw(7) << secs << " s "
+         << setw(8) << setprecision(1) << iterations / secs / 1e3
+         << " kplayouts/s, speedup " << setprecision(2) << one / secs
+         << ", move (" << row << "," << col << ") "
+         << setprecision(1) << 100.0 * chosen / total << "% of visits, "
+         << search.get_nodes() << " nodes" << endl;
+    if(n == maxthreads)
+      break;
+  }
+}
+
+void run(HexBoard& b, const char* title, unsigned iterations,
+         unsigned maxthreads, unsigned seed) {
+  cout << title << " (" << b.get_move_count() << " stones, "
+       << (b.get_current_player() == 1 ? "X" : "O") << " to move)" << endl;
+  run_search<RootParallelUCT>(b, "root-parallel", iterations, maxthreads,
+                              seed);
+  run_search<TreeParallelUCT>(b, "tree-parallel", iterations, maxthreads,
+                              seed);
+}
+
+int main(int argc, char** argv) {
+  unsigned dim = (argc > 1) ? atoi(argv[1]) : 11;
+  unsigned iterations = (argc > 2) ? atoi(argv[2]) : 100000;
+  unsigned maxthreads = (argc > 3) ? atoi(argv[3]) : thread::hardware_concurrency();
+  unsigned seed = (argc > 4) ? atoi(argv[4]) : 1;
+  if(maxthreads == 0)
+    maxthreads = 1;
+  if(dim < 3 || dim > BB_MAX_DIM || iterations == 0) {
+    cout << "usage: pmcts [dim] [iterations] [max threads] [seed]" << endl;
+    return 1;
+  }
+
+  cout << dim << "x" << dim << " board, " << iterations
+       << " playouts per search, seed " << seed << endl;
+
+  HexBoard empty(dim);
+  run(empty, "empty board", iterations, maxthreads, seed);
+
+  HexBoard opening(dim);
+  opening.play(dim/2, dim/2);
+  opening.play(dim/2, dim/2+1);
+  run(opening, "opening", iterations, maxthreads, seed);
+
+  HexBoard middle(dim);
+  random_moves(middle, dim*dim/3, seed);
+  run(middle, "middle game", iterations, maxthreads, seed);
+  return 0;
+}
@@ -0,0 +1,628 @@
+//--------------------------------------------------------------------
+// AIMCTSPlayer: a computer player that uses Monte Carlo Tree Search
+// with the UCT selection rule.
+// author: Luiz Ramos
+
+// The flat Monte Carlo  player (aiplayer.hpp) spends the same number of
+// playouts on every free cell, and learns nothing about the replies. Here
+// we grow a game tree instead, rooted at the current position, and every
+// iteration of the search takes four steps:
+//
+// (1) selection: starting at the root, descend to the child that
+//     maximizes the UCT score  wins/visits + C*sqrt(ln(parent visits) /
+//     visits), until we reach a leaf (children never visited come first);
+// (2) expansion: once a leaf has been visited 'expand' times, create one
+//     child for each free cell of its position and descend to one of them;
+// (3) playout: fill the rest of the board at random (random_playout, the
+//     same playouts of the flat player) and find out who won;
+// (4) backpropagation: add one visit to every node on the path, and one
+//     win to the nodes whose move was made by the winner.
+//
+// Promising moves get most of the visits, and so do the best replies to
+// them, so the search reads ahead instead of averaging over silly
+// replies. After the iterations, we play the most visited move at the root.
+//
+// A node that ends the game (its move connects the walls of the player
+// that made it) is marked when it is first reached, and from then on every
+// visit just backpropagates its winner. The tree lives in one vector of
+// nodes (the children of a node are consecutive), and each iteration
+// works on a copy of the root position (a memcpy), so nothing has to be
+// undone. With several threads, each one either grows a tree of its own
+// (RootParallelUCT) or they all grow one shared tree (TreeParallelUCT).
+
+#ifndef MCTSPLAYER_HPP
+#define MCTSPLAYER_HPP
+#include <iostream>
+#include <vector>
+#include <cmath> // sqrt, log
+#include <random> // default_random_engine
+#include <chrono> // chrono::system_clock
+#include <memory> // unique_ptr
+#include <atomic>
+#include <cstdint> // uint8_t, uint16_t
+#include "player.hpp"
+#include "aiplayer.hpp" // random_playout
+#include "parallel.hpp"
+using namespace std;
+
+// UCTSearch: the tree of a search from one position
+class UCTSearch {
+private:
+  struct Node {
+    vertID move; // move that led to this node (0 at the root)
+    unsigned first; // first child in nodes (0 if not expanded)
+    unsigned nchildren;
+    unsigned visits;
+    unsigned wins; // wins of the player that made 'move'
+    Color winner; // WHITE, unless 'move' ended the game
+  };
+
+  const HexTopology* topo;
+  HexPosition root; // position at the root of the tree
+  vector<Node> nodes; // nodes[0] is the root
+  double explore; // exploration constant C
+  unsigned expand; // visits before a leaf is expanded
+
+  // scratch space of an iteration
+  vector<unsigned> path; // nodes visited, from the root
+  vector<vertID> cells; // empty cells of a playout
+
+  // creates the children of node n, one per free cell of position p
+  void expand_node(unsigned n, const HexPosition& p) {
+    p.get_empty(*topo, cells);
+    unsigned first = nodes.size();
+    for(unsigned i=0; i<cells.size(); ++i) {
+      Node c = {cells[i], 0, 0, 0, 0, Color::WHITE};
+      nodes.push_back(c);
+    }
+    nodes[n].first = first;
+    nodes[n].nchildren = cells.size();
+  }
+
+  // the child of n with the highest UCT score
+  unsigned select(unsigned n) const {
+    const Node& node = nodes[n];
+    double logn = log(static_cast<double>(node.visits));
+    unsigned best = node.first;
+    double hiscore = -1;
+    for(unsigned c=node.first; c<node.first+node.nchildren; ++c) {
+      const Node& child = nodes[c];
+      if(child.visits == 0)
+        return c; // every move is tried once before we compare them
+      double score = static_cast<double>(child.wins) / child.visits +
+                     explore * sqrt(logn / child.visits);
+      if(score > hiscore) {
+        hiscore = score;
+        best = c;
+      }
+    }
+    return best;
+  }
+
+  // plays the move of child c on p; the first time c is reached, find out
+  // if its move wins the game
+  void descend(unsigned c, HexPosition& p) {
+    Color mover = p.get_current_player_symbol();
+    p.set_stone(*topo, nodes[c].move, mover);
+    p.pass_turn(*topo);
+    if(nodes[c].visits == 0 && p.is_victory(*topo, mover))
+      nodes[c].winner = mover;
+    path.push_back(c);
+  }
+
+  // the most visited child of the root
+  unsigned best_child() const {
+    const Node& r = nodes[0];
+    unsigned best = r.first;
+    for(unsigned c=r.first; c<r.first+r.nchildren; ++c)
+      if(nodes[c].visits > nodes[best].visits)
+        best = c;
+    return best;
+  }
+
+public:
+  UCTSearch(): topo(0), explore(0.7), expand(4) {}
+
+  void set_exploration(double c) { explore = c; }
+  void set_expand_threshold(unsigned v) { expand = (v > 0) ? v : 1; }
+
+  // starts a new tree at position p (the game must not be over)
+  void reset(const HexTopology& t, const HexPosition& p) {
+    topo = &t;
+    root = p;
+    nodes.clear();
+    Node r = {0, 0, 0, 0, 0, Color::WHITE};
+    nodes.push_back(r);
+    expand_node(0, root);
+  }
+
+  // runs one iteration of the search
+  template <class rng_t>
+  void iterate(rng_t& gen) {
+    HexPosition p = root;
+    path.clear();
+    path.push_back(0);
+
+    // selection (and expansion): walk down to a leaf or to the end of a game
+    unsigned n = 0;
+    while(nodes[n].winner == Color::WHITE) {
+      if(nodes[n].nchildren == 0) {
+        if(nodes[n].visits < expand)
+          break;
+        expand_node(n, p);
+      }
+      n = select(n);
+      descend(n, p);
+    }
+
+    // playout
+    Color winner = nodes[n].winner;
+    if(winner == Color::WHITE) {
+      p.get_empty(*topo, cells);
+      winner = random_playout(*topo, p, cells, p.get_current_player_symbol(),
+                              gen);
+    }
+
+    // backpropagation: the root's move belongs to the player that is not
+    // to move there, and the players alternate on the way down
+    Color mover = (root.is_p1_turn() ? Color::RED : Color::BLUE);
+    for(unsigned i=0; i<path.size(); ++i) {
+      Node& node = nodes[path[i]];
+      node.visits++;
+      if(mover == winner)
+        node.wins++;
+      mover = (mover==Color::BLUE ? Color::RED : Color::BLUE);
+    }
+  }
+
+  // the most visited move at the root
+  vertID best_move() const { return nodes[best_child()].move; }
+
+  // acessor methods
+  unsigned get_nodes() const { return nodes.size(); }
+  unsigned get_root_visits() const { return nodes[0].visits; }
+  // win rate of the most visited move (for the player to move at the root)
+  double get_best_rate() const {
+    const Node& b = nodes[best_child()];
+    return b.visits ? static_cast<double>(b.wins) / b.visits : 0;
+  }
+
+  // statistics of the i-th move at the root; the moves are the free cells
+  // in increasing order, the same in every tree grown from one position
+  unsigned get_root_children() const { return nodes[0].nchildren; }
+  vertID get_child_move(unsigned i) const {
+    return nodes[nodes[0].first+i].move;
+  }
+  unsigned get_child_visits(unsigned i) const {
+    return nodes[nodes[0].first+i].visits;
+  }
+  unsigned get_child_wins(unsigned i) const {
+    return nodes[nodes[0].first+i].wins;
+  }
+};
+
+// RootParallelUCT: root parallelization. Every thread grows its own tree
+// from the same position, with its own random number generator, and
+// shares nothing with the others while searching; at the end the visits
+// (and wins) of the moves at the root are summed over the trees, and we
+// pick the move with the most visits. The iterations are split among the
+// threads, so the same budget finishes sooner; the trees are smaller, but
+// their sum samples the root about as well as one tree of the same size.
+class RootParallelUCT {
+private:
+  // the tree of each thread (its node vector grows at every expansion,
+  // so it is padded to keep the threads off each other's lines, see
+  // CACHE_LINE)
+  struct Worker {
+    UCTSearch tree;
+    char pad[CACHE_LINE];
+  };
+
+  unique_ptr<ThreadPool> pool;
+  vector<Worker> trees; // one per thread (reused by every search)
+  double explore; // exploration constant C of every tree
+  unsigned expand; // visits before a leaf is expanded, in every tree
+  vector<unsigned> visits, wins; // merged statistics of the root moves
+
+public:
+  RootParallelUCT(unsigned threads = default_threads()):
+    explore(0.7), expand(4) {
+    set_threads(threads);
+  }
+
+  // (the trees added here get the current settings)
+  void set_threads(unsigned n) {
+    pool.reset(new ThreadPool((n > 0) ? n : 1));
+    trees.resize(pool->size());
+    for(unsigned t=0; t<trees.size(); ++t) {
+      trees[t].tree.set_exploration(explore);
+      trees[t].tree.set_expand_threshold(expand);
+    }
+  }
+  unsigned get_threads() const { return pool->size(); }
+
+  void set_exploration(double c) {
+    explore = c;
+    for(unsigned t=0; t<trees.size(); ++t)
+      trees[t].tree.set_exploration(c);
+  }
+  void set_expand_threshold(unsigned v) {
+    expand = (v > 0) ? v : 1;
+    for(unsigned t=0; t<trees.size(); ++t)
+      trees[t].tree.set_expand_threshold(v);
+  }
+
+  // runs 'iterations' iterations from position p (tree t uses seed+t) and
+  // returns the move with the most visits over all trees; when 'label' is
+  // given, the first thread shows its progress after it
+  vertID search(const HexTopology& topo, const HexPosition& p,
+                unsigned iterations, unsigned seed, const char* label = 0) {
+    unsigned nt = trees.size();
+    auto task = [&](unsigned t) {
+      UCTSearch& tree = trees[t].tree;
+      tree.reset(topo, p);
+      default_random_engine gen(seed + t);
+      unsigned n = iterations/nt + (t < iterations%nt ? 1 : 0);
+      unsigned step = (n >= 100) ? n/100 : 1;
+      for(unsigned i=0; i<n; ++i) {
+        if(label && t == 0 && i % step == 0)
+          cout << "\r" << label << " thinking..." << ((i*100)/n) << "%   "
+               << flush;
+        tree.iterate(gen);
+      }
+    };
+    pool->run(task);
+    if(label)
+      cout << "\r" << label << " thinking...100%   " << endl;
+
+    // merge the root statistics (ties go to the first move)
+    unsigned moves = trees[0].tree.get_root_children();
+    visits.assign(moves, 0);
+    wins.assign(moves, 0);
+    for(unsigned t=0; t<nt; ++t) {
+      for(unsigned i=0; i<moves; ++i) {
+        visits[i] += trees[t].tree.get_child_visits(i);
+        wins[i] += trees[t].tree.get_child_wins(i);
+      }
+    }
+    unsigned best = 0;
+    for(unsigned i=1; i<moves; ++i)
+      if(visits[i] > visits[best])
+        best = i;
+    return trees[0].tree.get_child_move(best);
+  }
+
+  // merged statistics of the last search, per root move
+  const vector<unsigned>& get_visits() const { return visits; }
+  const vector<unsigned>& get_wins() const { return wins; }
+  // total number of tree nodes of the last search
+  unsigned get_nodes() const {
+    unsigned n = 0;
+    for(unsigned t=0; t<trees.size(); ++t)
+      n += trees[t].tree.get_nodes();
+    return n;
+  }
+};
+
+// TreeParallelUCT: tree parallelization. All threads grow one shared
+// tree, so a deep search uses every core. No locks are taken:
+//
+// - visits and wins are atomic counters;
+// - virtual loss: a thread adds its visit to every node on its way down,
+//   before it knows the result, and only adds the win on the way back; in
+//   the meantime the node looks like a loss to the other threads, so they
+//   spread over other moves instead of piling onto the same path;
+// - expansion: a leaf is claimed by a compare-and-swap on its state
+//   (LEAF -> EXPANDING); the winner reserves a block of nodes with an
+//   atomic add, fills in the children and publishes them (EXPANDED, with
+//   release order); a thread that finds a node being expanded doesn't wait
+//   and plays out from there;
+// - the game-ending test of a node is claimed by the first thread that
+//   reaches it; if another thread arrives before the answer is known, its
+//   playout still finds the right winner (a won game stays won).
+//
+// The nodes live in an array allocated before the threads start (sized
+// for the number of iterations, up to MAX_NODES); when it fills up, the
+// leaves are no longer expanded. The results depend on how the threads
+// interleave, so they are not repeatable from the seed alone.
+class TreeParallelUCT {
+private:
+  static const unsigned MAX_NODES = 1 << 22;
+  enum: uint8_t {LEAF, EXPANDING, EXPANDED, FULL}; // states of a node
+
+  struct Node {
+    atomic<unsigned> visits; // finished visits plus those in flight
+    atomic<unsigned> wins; // wins of the player that made 'move'
+    atomic<unsigned> first; // first child (valid once EXPANDED)
+    atomic<uint8_t> state;
+    atomic<bool> checked; // the game-ending test was claimed
+    atomic<Color> winner; // WHITE, unless 'move' ended the game
+    uint16_t nchildren; // (valid once EXPANDED)
+    uint16_t move; // move that led to this node (vertex IDs fit in 16 bits)
+  };
+
+  // scratch space of each thread (changed at every step of a descent, so
+  // it is padded to keep the threads off each other's lines, see
+  // CACHE_LINE)
+  struct Worker {
+    vector<unsigned> path; // nodes visited, from the root
+    vector<vertID> cells; // free cells of an expansion or a playout
+    char pad[CACHE_LINE];
+  };
+
+  unique_ptr<ThreadPool> pool;
+  vector<Worker> workers;
+  unique_ptr<Node[]> nodes;
+  unsigned capacity; // size of nodes
+  atomic<unsigned> used; // nodes handed out (may run past capacity)
+  const HexTopology* topo;
+  HexPosition root;
+  double explore; // exploration constant C
+  unsigned expand; // visits before a leaf is expanded
+  vector<unsigned> visits, wins; // statistics of the root moves
+
+  void init_node(unsigned n, vertID move) {
+    Node& node = nodes[n];
+    node.visits.store(0, memory_order_relaxed);
+    node.wins.store(0, memory_order_relaxed);
+    node.first.store(0, memory_order_relaxed);
+    node.state.store(LEAF, memory_order_relaxed);
+    node.checked.store(false, memory_order_relaxed);
+    node.winner.store(Color::WHITE, memory_order_relaxed);
+    node.nchildren = 0;
+    node.move = static_cast<uint16_t>(move);
+  }
+
+  // tries to create the children of node n (at position p); false if
+  // another thread got there first or there is no room left
+  bool expand_node(unsigned n, const HexPosition& p, Worker& w) {
+    Node& node = nodes[n];
+    uint8_t leaf = LEAF;
+    if(!node.state.compare_exchange_strong(leaf, EXPANDING))
+      return false;
+
+    p.get_empty(*topo, w.cells);
+    unsigned k = w.cells.size();
+    unsigned first = used.fetch_add(k);
+    if(k == 0 || first + k > capacity) {
+      node.state.store(FULL, memory_order_release);
+      return false;
+    }
+    for(unsigned i=0; i<k; ++i)
+      init_node(first+i, w.cells[i]);
+    node.nchildren = k;
+    node.first.store(first, memory_order_relaxed);
+    node.state.store(EXPANDED, memory_order_release);
+    return true;
+  }
+
+  // the child of (expanded) node n with the highest UCT score, counting
+  // the visits in flight as losses
+  unsigned select(unsigned n) const {
+    const Node& node = nodes[n];
+    unsigned first = node.first.load(memory_order_relaxed);
+    double logn = log(static_cast<double>(
+                        node.visits.load(memory_order_relaxed)));
+    unsigned best = first;
+    double hiscore = -1;
+    for(unsigned c=first; c<first+node.nchildren; ++c) {
+      unsigned v = nodes[c].visits.load(memory_order_relaxed);
+      if(v == 0)
+        return c;
+      double score = static_cast<double>(
+                       nodes[c].wins.load(memory_order_relaxed)) / v +
+                     explore * sqrt(logn / v);
+      if(score > hiscore) {
+        hiscore = score;
+        best = c;
+      }
+    }
+    return best;
+  }
+
+  // one iteration of the search, on thread w
+  template <class rng_t>
+  void iterate(Worker& w, rng_t& gen) {
+    HexPosition p = root;
+    w.path.clear();
+    w.path.push_back(0);
+    nodes[0].visits.fetch_add(1, memory_order_relaxed);
+
+    // selection and expansion (with virtual loss)
+    unsigned n = 0;
+    while(nodes[n].winner.load(memory_order_relaxed) == Color::WHITE) {
+      uint8_t st = nodes[n].state.load(memory_order_acquire);
+      if(st != EXPANDED) {
+        if(st != LEAF ||
+           nodes[n].visits.load(memory_order_relaxed) <= expand ||
+           !expand_node(n, p, w))
+          break;
+      }
+      n = select(n);
+      Node& child = nodes[n];
+      child.visits.fetch_add(1, memory_order_relaxed);
+
+      Color mover = p.get_current_player_symbol();
+      p.set_stone(*topo, child.move, mover);
+      p.pass_turn(*topo);
+      if(!child.checked.load(memory_order_relaxed) &&
+         !child.checked.exchange(true) && p.is_victory(*topo, mover))
+        child.winner.store(mover, memory_order_relaxed);
+      w.path.push_back(n);
+    }
+
+    // playout
+    Color winner = nodes[n].winner.load(memory_order_relaxed);
+    if(winner == Color::WHITE) {
+      p.get_empty(*topo, w.cells);
+      winner = random_playout(*topo, p, w.cells,
+                              p.get_current_player_symbol(), gen);
+    }
+
+    // backpropagation: the visits were counted on the way down
+    Color mover = (root.is_p1_turn() ? Color::RED : Color::BLUE);
+    for(unsigned i=0; i<w.path.size(); ++i) {
+      if(mover == winner)
+        nodes[w.path[i]].wins.fetch_add(1, memory_order_relaxed);
+      mover = (mover==Color::BLUE ? Color::RED : Color::BLUE);
+    }
+  }
+
+public:
+  TreeParallelUCT(unsigned threads = default_threads()):
+    capacity(0), used(0), topo(0), explore(0.7), expand(4) {
+    set_threads(threads);
+  }
+
+  void set_threads(unsigned n) {
+    pool.reset(new ThreadPool((n > 0) ? n : 1));
+    workers.resize(pool->size());
+  }
+  unsigned get_threads() const { return pool->size(); }
+
+  void set_exploration(double c) { explore = c; }
+  void set_expand_threshold(unsigned v) { expand = (v > 0) ? v : 1; }
+
+  // runs 'iterations' iterations from position p (thread t uses seed+t)
+  // and returns the most visited move; when 'label' is given, the first
+  // thread shows the progress of the search
+  vertID search(const HexTopology& t, const HexPosition& p,
+                unsigned iterations, unsigned seed, const char* label = 0) {
+    topo = &t;
+    root = p;
+
+    // room for every expansion the iterations can make
+    Worker& w0 = workers[0];
+    p.get_empty(t, w0.cells);
+    unsigned k = w0.cells.size();
+    uint64_t need = (static_cast<uint64_t>(iterations)/expand + 2) * k;
+    unsigned cap = (need < MAX_NODES) ? need : MAX_NODES;
+    if(cap > capacity) {
+      nodes.reset(new Node[cap]);
+      capacity = cap;
+    }
+
+    // the root and its children
+    init_node(0, 0);
+    for(unsigned i=0; i<k; ++i)
+      init_node(1+i, w0.cells[i]);
+    nodes[0].nchildren = k;
+    nodes[0].first.store(1, memory_order_relaxed);
+    nodes[0].state.store(EXPANDED, memory_order_relaxed);
+    used.store(1+k);
+
+    // the threads take iterations until they run out
+    atomic<unsigned> next(0);
+    unsigned step = (iterations >= 100) ? iterations/100 : 1;
+    auto task = [&](unsigned id) {
+      default_random_engine gen(seed + id);
+      unsigned shown = 0; // next iteration to show
+      for(unsigned i; (i = next++) < iterations; ) {
+        if(label && id == 0 && i >= shown) {
+          cout << "\r" << label << " thinking..." << ((i*100)/iterations)
+               << "%   " << flush;
+          shown = i + step;
+        }
+        iterate(workers[id], gen);
+      }
+    };
+    pool->run(task);
+    if(label)
+      cout << "\r" << label << " thinking...100%   " << endl;
+
+    // statistics of the root moves (ties go to the first move)
+    visits.resize(k);
+    wins.resize(k);
+    unsigned best = 0;
+    for(unsigned i=0; i<k; ++i) {
+      visits[i] = nodes[1+i].visits.load();
+      wins[i] = nodes[1+i].wins.load();
+      if(visits[i] > visits[best])
+        best = i;
+    }
+    return nodes[1+best].move;
+  }
+
+  // statistics of the last search, per root move
+  const vector<unsigned>& get_visits() const { return visits; }
+  const vector<unsigned>& get_wins() const { return wins; }
+  // number of tree nodes of the last search
+  unsigned get_nodes() const {
+    unsigned n = used.load();
+    return (n < capacity) ? n : capacity;
+  }
+};
+
+// parallel search modes of AIMCTSPlayer:
+// ROOT = one tree per thread, root statistics merged (RootParallelUCT)
+// TREE = one tree shared by all threads (TreeParallelUCT)
+enum class Parallelism: int {ROOT, TREE};
+
+class AIMCTSPlayer: public Player {
+private:
+  // random number generator (draws the seed of each turn)
+  default_random_engine gen;
+  // the searches (rebuilt for every move); the one not in use keeps a
+  // single thread, so it holds no idle threads
+  RootParallelUCT root_search;
+  TreeParallelUCT tree_search;
+  Parallelism mode;
+  unsigned threads;
+  // number of iterations (playouts) per move, over all threads
+  int iterations;
+
+public:
+  AIMCTSPlayer(const char* nm, HexBoard *b,
+               unsigned threads = default_threads(),
+               Parallelism mode = Parallelism::ROOT):
+    // initializes the superclass
+    Player(nm,b),
+    // initializes the random number generator with the current time
+    gen(chrono::system_clock::now().time_since_epoch().count()),
+    root_search(1), tree_search(1), mode(mode), threads(threads),
+    iterations(100000) { set_parallelism(mode); }
+
+  void play(int& row, int& col);
+
+  // sets the number of playouts per move and the parameters of the search
+  void set_iterations(int n) { iterations = n; }
+  void set_exploration(double c) {
+    root_search.set_exploration(c);
+    tree_search.set_exploration(c);
+  }
+  void set_expand_threshold(unsigned v) {
+    root_search.set_expand_threshold(v);
+    tree_search.set_expand_threshold(v);
+  }
+  // sets the number of threads of the search
+  void set_threads(unsigned n) {
+    threads = n;
+    set_parallelism(mode);
+  }
+  // chooses between independent trees and one shared tree
+  void set_parallelism(Parallelism m) {
+    mode = m;
+    root_search.set_threads(mode == Parallelism::ROOT ? threads : 1);
+    tree_search.set_threads(mode == Parallelism::TREE ? threads : 1);
+  }
+  // reseeds the random number generator (for repeatable games)
+  void set_seed(unsigned s) { gen.seed(s); }
+};
+
+// Searches from the position of the gameboard and plays the most visited
+// move
+void AIMCTSPlayer::play(int& row, int& col) {
+  const HexTopology& topo = *board->get_hex_topology();
+  vertID winner;
+  if(mode == Parallelism::TREE)
+    winner = tree_search.search(topo, board->get_position(), iterations,
+                                gen(), name.c_str());
+  else
+    winner = root_search.search(topo, board->get_position(), iterations,
+                                gen(), name.c_str());
+
+  // return the corresponding row,col coordinates of the best move
+  assert(winner != 0); // 0 is an invalid playable position
+  board->vertex_to_row_col(winner,row,col);
+}
+#endif
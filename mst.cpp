@@ -0,0 +1,92 @@
+//--------------------------------------------------------------------
+// Graph algorithms benchmark
+// author: Luiz Ramos
+
+// Runs Dijkstra, Prim and Kruskal on a large random graph and reports
+// how long each one takes and how many edges per second it processes,
+// both on the Graph ADT and on its frozen (CSR) version.
+//
+// usage: pmst [nodes] [edges] [seed]
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib> // atoi
+#include <chrono>
+#include "graph.hpp"
+#include "csrgraph.hpp"
+#include "generator.hpp"
+#include "dijkstra.hpp"
+#include "mst.hpp"
+using namespace std;
+
+typedef Graph<vertID,double> WGraph;
+typedef CSRGraph<vertID,double> WCSRGraph;
+
+// seconds elapsed since 'start'
+double elapsed(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* name, double secs, unsigned edges) {
+  cout << setw(22) << left << name << right
+       << setw(10) << fixed << setprecision(3) << secs << " s"
+       << setw(10) << setprecision(2) << (edges / secs / 1e6) << " Medges/s"
+       << endl;
+}
+
+// runs all algorithms on g (a Graph or a CSRGraph); the scratch objects
+// are shared between runs, like a long-running user of the ADT would do
+template <class graph_t>
+void run(graph_t& g, const char* label,
+         ShortestPaths<double>& sp, SpanningForest<double>& sf) {
+  unsigned m = g.get_edges();
+  string prefix(label);
+
+  chrono::steady_clock::time_point t = chrono::steady_clock::now();
+  dijkstra(g, 0, sp);
+  report((prefix + " dijkstra").c_str(), elapsed(t), m);
+
+  t = chrono::steady_clock::now();
+  prim(g, sf);
+  report((prefix + " prim").c_str(), elapsed(t), m);
+  double wprim = sf.get_weight();
+
+  t = chrono::steady_clock::now();
+  kruskal(g, sf);
+  report((prefix + " kruskal").c_str(), elapsed(t), m);
+
+  cout << "  MST weight " << setprecision(2) << wprim << " (prim) "
+       << sf.get_weight() << " (kruskal), "
+       << sf.get_trees(g.get_nodes()) << " tree(s)" << endl;
+}
+
+int main(int argc, char** argv) {
+  unsigned nodes = (argc > 1) ? atoi(argv[1]) : 1000000;
+  unsigned edges = (argc > 2) ? atoi(argv[2]) : 4*nodes;
+  unsigned seed = (argc > 3) ? atoi(argv[3]) : 1;
+
+  cout << "Random graph: " << nodes << " nodes, " << edges << " edges, seed "
+       << seed << endl;
+
+  chrono::steady_clock::time_point t = chrono::steady_clock::now();
+  WGraph g;
+  random_graph(g, nodes, edges, 1.0, 100.0, seed);
+  report("generate", elapsed(t), edges);
+
+  t = chrono::steady_clock::now();
+  WCSRGraph csr(g);
+  report("freeze (CSR)", elapsed(t), edges);
+
+  ShortestPaths<double> sp;
+  SpanningForest<double> sf;
+  run(g, "graph", sp, sf);
+  run(csr, "csr", sp, sf);
+
+  // a sample shortest path, as a sanity check
+  vertID far = nodes-1;
+  vector<vertID> path;
+  sp.get_path(far, path);
+  cout << "  distance 0 -> " << far << ": " << sp.get_distance(far)
+       << " (" << path.size() << " vertices)" << endl;
+  return 0;
+}
@@ -0,0 +1,127 @@
+// -------------------------------------------------------------------
+// mst.hpp
+//
+// Minimum spanning trees (forests,  if the graph is not connected) with
+// two classic algorithms:
+//
+// Prim: grows one tree at a time from a root, always taking the lightest
+// edge that leaves the tree. The candidate edges are kept in a DaryHeap
+// keyed by weight (one entry per vertex, with decrease-key), so it runs
+// in O(E log_D V) and walks the adjacency lists in order.
+//
+// Kruskal: sorts all edges by weight and keeps every edge that joins two
+// different trees, which we detect with DisjointSets. It runs in
+// O(E log E), dominated by the sort, and only needs a list of edges.
+//
+// Both write their result into a SpanningForest that the caller reuses
+// between runs, so the scratch buffers are allocated only once. The graph
+// must provide get_nodes(), get_degree(v), get_neighbor(v,i) and
+// get_neighbor_weight(v,i) (Graph and CSRGraph do); it is assumed to be
+// undirected (every edge appears in the lists of both endpoints).
+// author: Luiz Ramos
+
+#ifndef MST_HPP
+#define MST_HPP
+
+#include <vector>
+#include <algorithm> // sort
+#include "graph.hpp"
+#include "priorityqueue.hpp"
+#include "disjointset.hpp"
+using namespace std;
+
+template <class etype>
+class SpanningForest {
+private:
+  vector<WeightedEdge<etype> > tree; // edges of the forest
+  etype total; // sum of the weights of the forest
+
+  // scratch buffers (kept between runs)
+  DaryHeap<etype> queue; // Prim: lightest known edge into each vertex
+  vector<vertID> link; // Prim: other endpoint of that edge
+  vector<bool> done; // Prim: vertex already in the forest
+  vector<WeightedEdge<etype> > edges; // Kruskal: all edges of the graph
+  DisjointSets trees; // Kruskal: trees of the forest built so far
+
+  template <class graph_t, class wtype>
+  friend void prim(graph_t& g, SpanningForest<wtype>& f);
+  template <class graph_t, class wtype>
+  friend void kruskal(graph_t& g, SpanningForest<wtype>& f);
+
+public:
+  SpanningForest(): total() {}
+
+  etype get_weight() const { return total; }
+  unsigned get_edges() const { return tree.size(); }
+  const WeightedEdge<etype>& get_edge(unsigned i) const { return tree[i]; }
+  // number of trees in a forest of 'nodes' vertices
+  unsigned get_trees(unsigned nodes) const { return nodes - tree.size(); }
+};
+
+// computes a minimum spanning forest of g into f using Prim's algorithm
+template <class graph_t, class etype>
+void prim(graph_t& g, SpanningForest<etype>& f) {
+  unsigned n = g.get_nodes();
+  f.tree.clear();
+  f.total = etype();
+  f.queue.reset(n);
+  f.link.assign(n, NO_VERTEX);
+  f.done.assign(n, false);
+
+  for(vertID root=0; root<n; ++root) {
+    if(f.done[root])
+      continue;
+
+    // grow a new tree from root
+    f.queue.push(root, etype());
+    while(!f.queue.empty()) {
+      etype w = f.queue.top_key();
+      vertID v = f.queue.pop();
+      f.done[v] = true;
+      if(f.link[v] != NO_VERTEX) {
+        WeightedEdge<etype> e = {w, f.link[v], v};
+        f.tree.push_back(e);
+        f.total += w;
+      }
+
+      unsigned degree = g.get_degree(v);
+      for(unsigned i=0; i<degree; ++i) {
+        vertID u = g.get_neighbor(v, i);
+        if(!f.done[u] && f.queue.push(u, g.get_neighbor_weight(v, i)))
+          f.link[u] = v;
+      }
+    }
+  }
+}
+
+// computes a minimum spanning forest of g into f using Kruskal's algorithm
+template <class graph_t, class etype>
+void kruskal(graph_t& g, SpanningForest<etype>& f) {
+  unsigned n = g.get_nodes();
+  f.tree.clear();
+  f.total = etype();
+
+  // collect every edge once (from its lower endpoint)
+  f.edges.clear();
+  for(vertID v=0; v<n; ++v) {
+    unsigned degree = g.get_degree(v);
+    for(unsigned i=0; i<degree; ++i) {
+      vertID u = g.get_neighbor(v, i);
+      if(v < u) {
+        WeightedEdge<etype> e = {g.get_neighbor_weight(v, i), v, u};
+        f.edges.push_back(e);
+      }
+    }
+  }
+  sort(f.edges.begin(), f.edges.end());
+
+  f.trees.reset(n);
+  for(unsigned i=0; i<f.edges.size() && f.tree.size()+1<n; ++i) {
+    const WeightedEdge<etype>& e = f.edges[i];
+    if(f.trees.unite(e.x, e.y)) {
+      f.tree.push_back(e);
+      f.total += e.weight;
+    }
+  }
+}
+#endif
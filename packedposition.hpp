@@ -0,0 +1,173 @@
+//--------------------------------------------------------------------
+// Hex Game
+// author: Luiz Ramos
+
+// Packed positions: a compact encoding of a Hex position for storage
+// (transposition tables,  game databases). Each  playable cell takes 2
+// bits (00 = empty, 01 = BLUE, 10 = RED), in row-major order, followed
+// by one bit for the side to move (1 when player2 is to move), so an
+// 11x11 board fits in 31 bytes. The walls are implied by the size. The
+// side to move can't be derived from the stones: HexBoard doesn't pass
+// the turn after a winning move, so a won position has the winner to
+// move, and packing must give back the same position (and hash).
+
+// Packing works one row at  a time: we extract the row of each player
+// from its bitset and interleave the two words (BLUE on the even bits,
+// RED on the odd bits), so we never look at cells one by one.
+
+#ifndef PACKEDPOSITION_HPP
+#define PACKEDPOSITION_HPP
+
+#include <cstdint> // uint8_t, uint64_t
+#include <cstring> // memcmp, memset
+#include <functional> // hash
+#include "hexboard.hpp"
+using namespace std;
+
+// number of bytes of a packed position of a dim x dim board
+inline unsigned packed_size(unsigned dim) { return (2*dim*dim + 8) / 8; }
+
+// spreads the lowest 32 bits of x to the even bits of the result
+inline uint64_t spread_bits(uint64_t x) {
+  x &= 0xffffffffULL;
+  x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+  x = (x | (x << 8)) & 0x00ff00ff00ff00ffULL;
+  x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  x = (x | (x << 2)) & 0x3333333333333333ULL;
+  x = (x | (x << 1)) & 0x5555555555555555ULL;
+  return x;
+}
+
+// writes position p into out[0..packed_size(dim)-1]
+inline void pack_position(const HexTopology& t, const HexPosition& p,
+                          uint8_t* out) {
+  vertID dim = t.get_playable_dim();
+  const BitSet& blue = p.get_stones().get_stones(0);
+  const BitSet& red = p.get_stones().get_stones(1);
+  uint64_t acc = 0; // bits waiting to be written
+  unsigned nacc = 0, nout = 0;
+
+  for(vertID row=0; row<dim; ++row) {
+    vertID first = t.vertex(row,0);
+    uint64_t code = spread_bits(blue.extract(first, dim)) |
+                    (spread_bits(red.extract(first, dim)) << 1);
+    acc |= code << nacc;
+    nacc += 2*dim;
+    while(nacc >= 8) {
+      out[nout++] = static_cast<uint8_t>(acc);
+      acc >>= 8;
+      nacc -= 8;
+    }
+  }
+  // the side to move (there are at most 7 bits in acc)
+  acc |= static_cast<uint64_t>(!p.is_p1_turn()) << nacc;
+  out[nout++] = static_cast<uint8_t>(acc);
+}
+
+// rebuilds position p from in[0..packed_size(dim)-1]
+inline void unpack_position(const HexTopology& t, const uint8_t* in,
+                            HexPosition& p) {
+  vertID dim = t.get_playable_dim();
+  uint64_t mask = (static_cast<uint64_t>(1) << (2*dim)) - 1;
+  uint64_t acc = 0; // bits read but not decoded yet
+  unsigned nacc = 0, nin = 0;
+
+  p.reset(t);
+  for(vertID row=0; row<dim; ++row) {
+    while(nacc < 2*dim) {
+      acc |= static_cast<uint64_t>(in[nin++]) << nacc;
+      nacc += 8;
+    }
+    uint64_t code = acc & mask;
+    acc >>= 2*dim;
+    nacc -= 2*dim;
+
+    // visit the non-empty cells of the row
+    while(code != 0) {
+      unsigned b = __builtin_ctzll(code);
+      code &= code - 1;
+      p.set_stone(t, t.vertex(row, b/2), (b & 1) ? Color::RED : Color::BLUE);
+    }
+  }
+
+  // the bit after the cells is the side to move
+  if(nacc == 0)
+    acc = in[nin];
+  if(acc & 1)
+    p.pass_turn(t);
+}
+
+// PackedPosition<N>: a packed N x N position stored inline, so it can be
+// used as a key of hash tables without extra allocations.
+template <unsigned N>
+class PackedPosition {
+public:
+  static const unsigned BYTES = (2*N*N + 8) / 8;
+
+private:
+  uint8_t bytes[BYTES];
+
+public:
+  // the empty board
+  PackedPosition() { memset(bytes, 0, BYTES); }
+
+  PackedPosition(const HexTopology& t, const HexPosition& p) {
+    assert(t.get_playable_dim() == N);
+    pack_position(t, p, bytes);
+  }
+
+  PackedPosition(HexBoard& b) {
+    assert(b.get_playable_dim() == static_cast<int>(N));
+    pack_position(*b.get_hex_topology(), b.get_position(), bytes);
+  }
+
+  void unpack(const HexTopology& t, HexPosition& p) const {
+    assert(t.get_playable_dim() == N);
+    unpack_position(t, bytes, p);
+  }
+
+  // loads this position into board b (which starts with no moves)
+  void unpack(HexBoard& b) const {
+    HexPosition p;
+    unpack(*b.get_hex_topology(), p);
+    b.set_position(p);
+  }
+
+  // color of cell (row,col) of the playable area
+  Color get(vertID row, vertID col) const {
+    unsigned k = 2*(row*N + col);
+    switch((bytes[k >> 3] >> (k & 7)) & 3) {
+      case 1: return Color::BLUE;
+      case 2: return Color::RED;
+      default: return Color::WHITE;
+    }
+  }
+
+  const uint8_t* data() const { return bytes; }
+
+  bool operator==(const PackedPosition& o) const {
+    return memcmp(bytes, o.bytes, BYTES) == 0;
+  }
+  bool operator!=(const PackedPosition& o) const { return !(*this == o); }
+
+  // 64-bit FNV-1a hash of the packed bytes
+  uint64_t hash() const {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for(unsigned i=0; i<BYTES; ++i) {
+      h ^= bytes[i];
+      h *= 0x100000001b3ULL;
+    }
+    return h;
+  }
+};
+
+// lets unordered containers use PackedPosition<N> as a key
+namespace std {
+  template <unsigned N>
+  struct hash<PackedPosition<N> > {
+    size_t operator()(const PackedPosition<N>& p) const {
+      return static_cast<size_t>(p.hash());
+    }
+  };
+}
+#endif
@@ -0,0 +1,161 @@
+// -------------------------------------------------------------------
+// parallel.hpp
+//
+// Small helpers to split loops among threads: parallel_for starts threads
+// for one loop; ThreadPool keeps its threads for the life of the pool, for
+// code that runs many short parallel loops (e.g. one per move of a game).
+// author: Luiz Ramos
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional> // ref, function
+#include <cstddef> // size_t
+using namespace std;
+
+// size of a cache line: structures written by different threads are kept
+// this far apart, so the threads don't take the line from each other
+// (false sharing). Arrays of per-thread structures end each one with this
+// much padding: with C++11, vector doesn't honor an alignas larger than
+// 16 bytes, so aligning the structures wouldn't be enough.
+const size_t CACHE_LINE = 64;
+
+// number of threads to use when the user doesn't say (one per core)
+inline unsigned default_threads() {
+  unsigned n = thread::hardware_concurrency();
+  return (n > 0) ? n : 1;
+}
+
+// runs f(t, first, last) for t=0..nthreads-1 on consecutive slices of
+// [0,n); the calling thread takes the first slice (loops with fewer items
+// than threads run entirely on the calling thread)
+template <class F>
+void parallel_for(unsigned nthreads, size_t n, F& f) {
+  if(nthreads <= 1 || n < nthreads) {
+    f(0, 0, n);
+    return;
+  }
+
+  vector<thread> workers;
+  size_t chunk = (n + nthreads-1) / nthreads;
+  for(unsigned t=1; t<nthreads; ++t) {
+    size_t first = t*chunk, last = (first+chunk < n) ? first+chunk : n;
+    if(first < last)
+      workers.push_back(thread(ref(f), t, first, last));
+  }
+  f(0, 0, (chunk < n) ? chunk : n);
+  for(unsigned t=0; t<workers.size(); ++t)
+    workers[t].join();
+}
+
+// ThreadPool: nthreads-1 threads that sleep between jobs; the thread that
+// calls run() works as thread 0, so a pool of one thread has no workers and
+// runs everything on the caller
+class ThreadPool {
+private:
+  vector<thread> workers;
+  mutex lock;
+  condition_variable wake; // a job was posted (or the pool is closing)
+  condition_variable done; // the last worker finished the job
+  function<void(unsigned)> job; // current job, called with the thread index
+  unsigned generation; // number of jobs posted
+  unsigned running; // workers still busy with the current job
+  bool stop;
+
+  ThreadPool(const ThreadPool&); // no copies
+  ThreadPool& operator=(const ThreadPool&);
+
+  void work(unsigned t) {
+    unsigned seen = 0;
+    unique_lock<mutex> l(lock);
+    for(;;) {
+      while(!stop && generation == seen)
+        wake.wait(l);
+      if(stop)
+        return;
+      seen = generation;
+      l.unlock();
+      job(t);
+      l.lock();
+      if(--running == 0)
+        done.notify_one();
+    }
+  }
+
+public:
+  ThreadPool(unsigned nthreads = default_threads()):
+    generation(0), running(0), stop(false) {
+    for(unsigned t=1; t<nthreads; ++t)
+      workers.push_back(thread(&ThreadPool::work, this, t));
+  }
+
+  // number of threads, the caller included
+  unsigned size() const { return workers.size() + 1; }
+
+  // runs f(t) on every thread t=0..size()-1 and waits for all of them
+  template <class F>
+  void run(F& f) {
+    if(workers.empty()) {
+      f(0);
+      return;
+    }
+    {
+      lock_guard<mutex> l(lock);
+      job = ref(f);
+      running = workers.size();
+      generation++;
+    }
+    wake.notify_all();
+    f(0);
+
+    unique_lock<mutex> l(lock);
+    while(running > 0)
+      done.wait(l);
+  }
+
+  // runs f(t, first, last) on consecutive slices of [0,n), one per thread
+  // t (the same split as parallel_for, without starting any thread)
+  template <class F>
+  void for_slices(size_t n, F& f) {
+    unsigned nthreads = size();
+    if(nthreads <= 1 || n < nthreads) {
+      f(0, 0, n);
+      return;
+    }
+    size_t chunk = (n + nthreads-1) / nthreads;
+    auto body = [&](unsigned t) {
+      size_t first = t*chunk, last = (first+chunk < n) ? first+chunk : n;
+      if(first < last)
+        f(t, first, last);
+    };
+    run(body);
+  }
+
+  // calls f(t, i) for i=0..n-1, where t is the thread that took item i;
+  // items are handed out one at a time, so uneven items balance out
+  template <class F>
+  void for_each(size_t n, F& f) {
+    atomic<size_t> next(0);
+    auto body = [&](unsigned t) {
+      for(size_t i; (i = next++) < n; )
+        f(t, i);
+    };
+    run(body);
+  }
+
+  ~ThreadPool() {
+    {
+      lock_guard<mutex> l(lock);
+      stop = true;
+    }
+    wake.notify_all();
+    for(unsigned t=0; t<workers.size(); ++t)
+      workers[t].join();
+  }
+};
+#endif
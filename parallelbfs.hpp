@@ -0,0 +1,299 @@
+// -------------------------------------------------------------------
+// parallelbfs.hpp
+//
+// ParallelBFS: a  multithreaded,  direction-optimizing breadth-first
+// search (Beamer et al.). Each level is expanded in one of two ways:
+//
+// top-down: every vertex of the frontier (a list) looks at its neighbors
+// and claims the unvisited ones with a compare-and-swap on their parent.
+// Cheap while the frontier is small.
+//
+// bottom-up: every unvisited vertex looks for a parent in the frontier (a
+// bitmap) and stops at the first one it finds. Once the frontier holds
+// a large part of the graph, most edges examined by top-down would lead
+// to visited vertices, and bottom-up skips them.
+//
+// We switch to bottom-up when the edges leaving the frontier outnumber
+// the edges of the unvisited vertices by more than ALPHA, and back to
+// top-down when the frontier shrinks below 1/BETA of the vertices. The
+// vertices are split among the threads in contiguous ranges; in
+// bottom-up, each thread owns whole words of the next bitmap, so it needs
+// no atomics at all. The threads belong to a ThreadPool that lives as
+// long as the search object: a graph with a large diameter takes
+// thousands of levels, and starting threads for each of them would cost
+// more than the levels themselves.
+//
+// The graph can be a CSRGraph (the fast case: the adjacency is one
+// array) or a Graph of any policy; we only read get_nodes(),
+// get_degree(v) and get_neighbor(v,i), which is safe from many threads
+// as long as nobody modifies the graph. The result (level and parent of
+// every vertex) stays in the ParallelBFS object, which can be reused.
+// author: Luiz Ramos
+
+#ifndef PARALLELBFS_HPP
+#define PARALLELBFS_HPP
+
+#include <vector>
+#include <memory> // unique_ptr
+#include <cstdint> // uint64_t
+#include <cassert>
+#include "graph.hpp"
+#include "parallel.hpp"
+using namespace std;
+
+class ParallelBFS {
+public:
+  // level of the vertices that can't be reached from the source
+  static const unsigned UNREACHED = static_cast<unsigned>(-1);
+  // switching thresholds (see above)
+  static const unsigned ALPHA = 14, BETA = 24;
+
+private:
+  unsigned nthreads;
+  unique_ptr<ThreadPool> pool; // runs every step of the search
+  vector<unsigned> level; // distance (in edges) from the source
+  // parent in the BFS tree: the source is its own parent, and the
+  // vertices not reached have NO_VERTEX (so a parent marks a visit)
+  vector<vertID> parent;
+
+  // results of each thread in a step (written by the thread at every
+  // step, so they are padded to keep the threads off each other's
+  // lines, see CACHE_LINE)
+  struct Worker {
+    vector<vertID> local; // its slice of the next queue
+    uint64_t scouted; // edges leaving its part of the new frontier
+    unsigned found; // vertices of its part of the new frontier
+    char pad[CACHE_LINE];
+  };
+
+  // frontier as a list (top-down) and as bitmaps (bottom-up)
+  vector<vertID> queue;
+  vector<uint64_t> front, next;
+  vector<Worker> workers;
+
+  unsigned reached; // vertices reached by the last search
+  unsigned td_steps, bu_steps; // levels expanded in each direction
+
+  // claims v for parent p; false if another thread got there first
+  bool claim(vertID v, vertID p) {
+    vertID expected = NO_VERTEX;
+    return __atomic_compare_exchange_n(&parent[v], &expected, p, false,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+  }
+
+  bool in_front(vertID v) const { return (front[v >> 6] >> (v & 63)) & 1; }
+
+  // joins the per-thread queues into queue
+  void gather() {
+    queue.clear();
+    for(unsigned t=0; t<nthreads; ++t) {
+      vector<vertID>& local = workers[t].local;
+      queue.insert(queue.end(), local.begin(), local.end());
+      local.clear();
+    }
+  }
+
+  template <class graph_t> struct TopDown;
+  template <class graph_t> struct BottomUp;
+  struct QueueToBitmap;
+  struct BitmapToQueue;
+
+public:
+  ParallelBFS(unsigned threads = 0):
+    reached(0), td_steps(0), bu_steps(0) {
+    set_threads((threads > 0) ? threads : default_threads());
+  }
+
+  void set_threads(unsigned threads) {
+    nthreads = (threads > 0) ? threads : 1;
+    pool.reset(new ThreadPool(nthreads));
+  }
+  unsigned get_threads() const { return nthreads; }
+
+  // runs the search from src
+  template <class graph_t>
+  void run(graph_t& g, vertID src);
+
+  unsigned get_level(vertID v) const { return level[v]; }
+  vertID get_parent(vertID v) const { return parent[v]; }
+  bool is_reached(vertID v) const { return level[v] != UNREACHED; }
+  unsigned get_reached() const { return reached; }
+  unsigned get_top_down_steps() const { return td_steps; }
+  unsigned get_bottom_up_steps() const { return bu_steps; }
+};
+
+// expands the queue: slice [first,last) of the queue goes to thread t
+template <class graph_t>
+struct ParallelBFS::TopDown {
+  ParallelBFS& s;
+  graph_t& g;
+  unsigned depth; // level of the new vertices
+
+  TopDown(ParallelBFS& bfs, graph_t& gr, unsigned d): s(bfs), g(gr), depth(d) {}
+
+  void operator()(unsigned t, size_t first, size_t last) {
+    vector<vertID>& out = s.workers[t].local;
+    uint64_t edges = 0;
+    for(size_t i=first; i<last; ++i) {
+      vertID v = s.queue[i];
+      unsigned degree = g.get_degree(v);
+      for(unsigned k=0; k<degree; ++k) {
+        vertID w = g.get_neighbor(v, k);
+        if(__atomic_load_n(&s.parent[w], __ATOMIC_RELAXED) == NO_VERTEX &&
+           s.claim(w, v)) {
+          s.level[w] = depth;
+          out.push_back(w);
+          edges += g.get_degree(w);
+        }
+      }
+    }
+    s.workers[t].scouted = edges;
+    s.workers[t].found = out.size();
+  }
+};
+
+// fills the next bitmap: words [first,last) go to thread t
+template <class graph_t>
+struct ParallelBFS::BottomUp {
+  ParallelBFS& s;
+  graph_t& g;
+  unsigned depth;
+
+  BottomUp(ParallelBFS& bfs, graph_t& gr, unsigned d): s(bfs), g(gr), depth(d) {}
+
+  void operator()(unsigned t, size_t first, size_t last) {
+    unsigned n = g.get_nodes(), count = 0;
+    uint64_t edges = 0;
+    for(size_t w=first; w<last; ++w) {
+      uint64_t bits = 0;
+      vertID end = (w*64 + 64 < n) ? w*64 + 64 : n;
+      for(vertID v=w*64; v<end; ++v) {
+        if(s.parent[v] != NO_VERTEX)
+          continue;
+        unsigned degree = g.get_degree(v);
+        for(unsigned k=0; k<degree; ++k) {
+          vertID u = g.get_neighbor(v, k);
+          if(s.in_front(u)) {
+            s.parent[v] = u;
+            s.level[v] = depth;
+            bits |= static_cast<uint64_t>(1) << (v & 63);
+            edges += degree;
+            count++;
+            break;
+          }
+        }
+      }
+      s.next[w] = bits;
+    }
+    s.workers[t].scouted = edges;
+    s.workers[t].found = count;
+  }
+};
+
+// converts the queue into the front bitmap: words [first,last)
+struct ParallelBFS::QueueToBitmap {
+  ParallelBFS& s;
+  unsigned depth;
+
+  QueueToBitmap(ParallelBFS& bfs, unsigned d): s(bfs), depth(d) {}
+
+  // we can't scatter the queue without atomics, so each thread rebuilds
+  // its words from the levels instead
+  void operator()(unsigned, size_t first, size_t last) {
+    unsigned n = s.level.size();
+    for(size_t w=first; w<last; ++w) {
+      uint64_t bits = 0;
+      vertID end = (w*64 + 64 < n) ? w*64 + 64 : n;
+      for(vertID v=w*64; v<end; ++v)
+        if(s.level[v] == depth)
+          bits |= static_cast<uint64_t>(1) << (v & 63);
+      s.front[w] = bits;
+    }
+  }
+};
+
+// converts the front bitmap into per-thread queues: words [first,last)
+struct ParallelBFS::BitmapToQueue {
+  ParallelBFS& s;
+
+  BitmapToQueue(ParallelBFS& bfs): s(bfs) {}
+
+  void operator()(unsigned t, size_t first, size_t last) {
+    vector<vertID>& out = s.workers[t].local;
+    for(size_t w=first; w<last; ++w) {
+      uint64_t bits = s.front[w];
+      while(bits != 0) {
+        out.push_back(w*64 + __builtin_ctzll(bits));
+        bits &= bits - 1;
+      }
+    }
+  }
+};
+
+template <class graph_t>
+void ParallelBFS::run(graph_t& g, vertID src) {
+  unsigned n = g.get_nodes();
+  assert(src < n);
+  size_t words = (n + 63) / 64;
+  level.assign(n, static_cast<unsigned>(UNREACHED));
+  parent.assign(n, NO_VERTEX);
+  front.assign(words, 0);
+  next.assign(words, 0);
+  workers.resize(nthreads);
+  for(unsigned t=0; t<nthreads; ++t)
+    workers[t].local.clear();
+  td_steps = bu_steps = 0;
+
+  // edges of the unvisited vertices (an estimate of the bottom-up work)
+  uint64_t unexplored = 0;
+  for(vertID v=0; v<n; ++v)
+    unexplored += g.get_degree(v);
+
+  level[src] = 0;
+  parent[src] = src; // marks it as visited
+  queue.assign(1, src);
+  reached = 1;
+
+  uint64_t frontier_edges = g.get_degree(src);
+  unsigned frontier_size = 1;
+  bool bottom_up = false;
+
+  for(unsigned depth=1; frontier_size > 0; ++depth) {
+    unexplored -= frontier_edges;
+
+    // pick the direction of this step
+    if(!bottom_up && frontier_edges > unexplored / ALPHA) {
+      QueueToBitmap convert(*this, depth-1);
+      pool->for_slices(words, convert);
+      bottom_up = true;
+    } else if(bottom_up && frontier_size < n / BETA) {
+      BitmapToQueue convert(*this);
+      pool->for_slices(words, convert);
+      gather();
+      bottom_up = false;
+    }
+
+    for(unsigned t=0; t<nthreads; ++t)
+      workers[t].scouted = workers[t].found = 0;
+    if(bottom_up) {
+      BottomUp<graph_t> step(*this, g, depth);
+      pool->for_slices(words, step);
+      front.swap(next);
+      bu_steps++;
+    } else {
+      TopDown<graph_t> step(*this, g, depth);
+      pool->for_slices(queue.size(), step);
+      gather();
+      td_steps++;
+    }
+
+    frontier_edges = 0;
+    frontier_size = 0;
+    for(unsigned t=0; t<nthreads; ++t) {
+      frontier_edges += workers[t].scouted;
+      frontier_size += workers[t].found;
+    }
+    reached += frontier_size;
+  }
+}
+#endif
@@ -0,0 +1,129 @@
+// -------------------------------------------------------------------
+// priorityqueue.hpp
+//
+// DaryHeap: an indexed min-heap of vertex IDs, ordered by a key of type
+// ktype. Each vertex appears at most once, and its position in the heap
+// is tracked, so the key of a queued vertex can be decreased in place
+// (Dijkstra, Prim) instead of pushing duplicates. With D children per
+// node  the tree  is shallower than  a binary  heap (fewer moves  per
+// decrease-key) and the children of a node share a cache line, which
+// pays off on graphs with many more edges than vertices. D=4 is a good
+// default.
+// author: Luiz Ramos
+
+#ifndef PRIORITYQUEUE_HPP
+#define PRIORITYQUEUE_HPP
+
+#include <vector>
+#include <cassert>
+#include "graph.hpp"
+using namespace std;
+
+template <class ktype, unsigned D = 4>
+class DaryHeap {
+private:
+  static const unsigned NOT_QUEUED = static_cast<unsigned>(-1);
+
+  // each slot of the heap holds a vertex and its key, so comparisons don't
+  // jump to another array
+  struct Slot {
+    ktype key;
+    vertID v;
+  };
+
+  vector<Slot> heap; // the D-ary tree, stored level by level
+  vector<unsigned> where; // position of each vertex in heap, or NOT_QUEUED
+
+  void place(unsigned i, const Slot& s) {
+    heap[i] = s;
+    where[s.v] = i;
+  }
+
+  // moves the slot at i towards the root while it is smaller than its parent
+  void sift_up(unsigned i) {
+    Slot s = heap[i];
+    while(i > 0) {
+      unsigned p = (i-1) / D;
+      if(!(s.key < heap[p].key))
+        break;
+      place(i, heap[p]);
+      i = p;
+    }
+    place(i, s);
+  }
+
+  // moves the slot at i towards the leaves while a child is smaller
+  void sift_down(unsigned i) {
+    Slot s = heap[i];
+    unsigned n = heap.size();
+    for(;;) {
+      unsigned first = D*i + 1;
+      if(first >= n)
+        break;
+      unsigned last = (first + D < n) ? first + D : n;
+      unsigned best = first;
+      for(unsigned c=first+1; c<last; ++c)
+        if(heap[c].key < heap[best].key)
+          best = c;
+      if(!(heap[best].key < s.key))
+        break;
+      place(i, heap[best]);
+      i = best;
+    }
+    place(i, s);
+  }
+
+public:
+  DaryHeap() {}
+  DaryHeap(unsigned nodes) { reset(nodes); }
+
+  // empties the heap and prepares it for vertices 0..nodes-1 (the memory
+  // is kept, so a heap can be reused without allocations)
+  void reset(unsigned nodes) {
+    heap.clear();
+    where.assign(nodes, static_cast<unsigned>(NOT_QUEUED));
+  }
+
+  bool empty() const { return heap.empty(); }
+  unsigned size() const { return heap.size(); }
+  bool contains(vertID v) const { return where[v] != NOT_QUEUED; }
+  ktype get_key(vertID v) const { return heap[where[v]].key; }
+
+  // inserts v, or lowers its key if it is already queued with a larger one;
+  // returns false if v was kept unchanged
+  bool push(vertID v, ktype key) {
+    assert(v < where.size());
+    if(contains(v)) {
+      unsigned i = where[v];
+      if(!(key < heap[i].key))
+        return false;
+      heap[i].key = key;
+      sift_up(i);
+      return true;
+    }
+
+    Slot s = {key, v};
+    heap.push_back(s);
+    sift_up(heap.size()-1);
+    return true;
+  }
+
+  // vertex with the smallest key (the heap must not be empty)
+  vertID top() const { return heap[0].v; }
+  ktype top_key() const { return heap[0].key; }
+
+  // removes and returns the vertex with the smallest key
+  vertID pop() {
+    assert(!empty());
+    vertID v = heap[0].v;
+    where[v] = NOT_QUEUED;
+    Slot s = heap.back();
+    heap.pop_back();
+    if(!heap.empty()) {
+      heap[0] = s;
+      sift_down(0);
+    }
+    return v;
+  }
+};
+#endif
@@ -0,0 +1,273 @@
+//--------------------------------------------------------------------
+// Consistency tests
+// author: Luiz Ramos
+
+// Checks, with asserts, that the different representations of the board
+// agree with each other. Build and run with 'make test' (the asserts must
+// be enabled, so don't build it with -DNDEBUG).
+//
+// usage: ptest [seed]
+
+#include <iostream>
+#include <cstdlib> // atoi
+#include <cassert>
+#include <random>
+#include <algorithm> // shuffle
+#include <vector>
+#include <cstdio> // remove
+#include "hexboard.hpp"
+#include "graphio.hpp"
+#include "packedposition.hpp"
+#include "fixedboard.hpp"
+#include "generator.hpp"
+using namespace std;
+
+// Plays random moves on a board of the given size until someone wins,
+// checking the outcome of every move against a search of the board, and
+// then undoes the whole game. Sizes beyond BB_MAX_DIM have no bitboards,
+// so they exercise the graph-only version of the board.
+void test_playout(unsigned dim, unsigned seed) {
+  HexBoard b(dim);
+  default_random_engine gen(seed);
+  uint64_t empty_hash = b.get_hash();
+  assert(b.count_free_vertices() == dim*dim);
+
+  vector<vertID> cells;
+  b.get_free_vertices(cells);
+  assert(cells.size() == dim*dim);
+  shuffle(cells.begin(), cells.end(), gen);
+
+  Outcome outcome = Outcome::NO_WIN;
+  unsigned moves = 0;
+  for(unsigned i=0; i<cells.size() && outcome == Outcome::NO_WIN; ++i) {
+    Color sym = b.get_current_player_symbol();
+    outcome = b.play_vertex(cells[i]);
+    ++moves;
+    assert(outcome == Outcome::NO_WIN || outcome == Outcome::P1_WIN ||
+           outcome == Outcome::P2_WIN);
+    assert(b.is_victory(sym) == (outcome != Outcome::NO_WIN));
+    assert(b.count_free_vertices() == dim*dim - moves);
+    assert(b.play_vertex(cells[i]) == Outcome::OCC_ERROR);
+  }
+  // a full board always has a winner
+  assert(outcome != Outcome::NO_WIN);
+
+  vector<vertID> free;
+  b.get_free_vertices(free);
+  assert(free.size() == dim*dim - moves);
+  for(unsigned i=1; i<free.size(); ++i)
+    assert(free[i-1] < free[i]);
+
+  while(b.get_move_count() > 0)
+    b.undo();
+  assert(b.get_hash() == empty_hash);
+  assert(b.count_free_vertices() == dim*dim);
+  assert(b.get_current_player() == 1);
+
+  cout << "  " << dim << "x" << dim << " playout: " << moves << " moves, "
+       << outcome << endl;
+}
+
+// Saves a board with each topology and checks that the file holds every
+// edge of the board (and nothing else) and the colors of its vertices.
+void test_board_file(unsigned dim) {
+  const char* path = "ptest.hexg";
+  Topology tps[] = {Topology::EXPLICIT, Topology::IMPLICIT, Topology::FROZEN};
+  for(unsigned t=0; t<3; ++t) {
+    HexBoard b(dim, Backend::BITBOARD, tps[t]);
+    b.play(0, 0);
+    b.play(dim/2, dim/2);
+    assert(write_graph(path, b));
+
+    MappedGraph<Color,NoWeight> m;
+    assert(m.open(path));
+    assert(m.get_nodes() == b.get_nodes());
+    unsigned arcs = 0;
+    vector<vertID> neigh;
+    for(vertID v=0; v<b.get_nodes(); ++v) {
+      assert(m.get_vertex_key(v) == b.get_vertex_key(v));
+      b.get_neighbors(v, neigh);
+      assert(m.get_degree(v) == neigh.size());
+      for(unsigned i=0; i<neigh.size(); ++i)
+        assert(m.is_adjacent(v, neigh[i]));
+      arcs += neigh.size();
+    }
+    // (dim+2)^2 vertices: 3 edges per vertex, minus the missing ones
+    // along the last column, the last row and the first column
+    unsigned n = dim+2;
+    assert(m.get_edges() == arcs/2 && arcs/2 == 3*n*n - 4*n + 1);
+    m.close();
+  }
+  remove(path);
+  cout << "  " << dim << "x" << dim << " board files: ok" << endl;
+}
+
+// Packs and unpacks every position of a few random games on an N x N
+// board, won positions included (the winner is still to move there).
+template <unsigned N>
+void test_packed_positions(unsigned seed) {
+  HexBoard b(N);
+  const HexTopology& topo = *b.get_hex_topology();
+  default_random_engine gen(seed);
+  vector<vertID> cells;
+  unsigned positions = 0, won = 0;
+
+  for(unsigned game=0; game<20; ++game) {
+    b.reset_board();
+    Outcome outcome = Outcome::NO_WIN;
+    while(true) {
+      PackedPosition<N> packed(b);
+      HexPosition p;
+      packed.unpack(topo, p);
+      assert(p == b.get_position());
+      assert(p.get_hash() == b.get_hash());
+      assert(PackedPosition<N>(topo, p) == packed);
+      assert(PackedPosition<N>(topo, p).hash() == packed.hash());
+
+      HexBoard c(N);
+      packed.unpack(c);
+      assert(c.get_hash() == b.get_hash());
+      assert(c.get_current_player() == b.get_current_player());
+      // a board with moves forgets them, so they can't be undone on the
+      // new position
+      HexBoard d = b.clone();
+      packed.unpack(d);
+      assert(d.get_hash() == b.get_hash());
+      assert(d.get_move_count() == 0);
+      if(outcome == Outcome::NO_WIN) {
+        d.get_free_vertices(cells);
+        d.play_vertex(cells[0]);
+        d.undo();
+        assert(d.get_hash() == b.get_hash() && d.get_move_count() == 0);
+      }
+      ++positions;
+
+      if(outcome != Outcome::NO_WIN) {
+        ++won;
+        break;
+      }
+      b.get_free_vertices(cells);
+      outcome = b.play_vertex(cells[gen() % cells.size()]);
+    }
+  }
+  assert(won == 20);
+  cout << "  " << N << "x" << N << " packed positions: " << positions
+       << " round trips, " << won << " won" << endl;
+}
+
+// Plays the same random games on a FixedHexBoard<N> and on a HexBoard,
+// retracting a move now and then, and checks that both boards agree after
+// every step. Called through dispatch_board_size: sizes without a fixed
+// board report that they were skipped.
+struct FixedBoardCheck {
+  unsigned seed;
+
+  template <unsigned N>
+  bool run() {
+    FixedHexBoard<N> f;
+    HexBoard b(N);
+    const HexTopology& topo = *b.get_hex_topology();
+    default_random_engine gen(seed);
+    vector<vertID> fcells, bcells;
+
+    for(unsigned game=0; game<10; ++game) {
+      f.reset_board();
+      b.reset_board();
+      Outcome outcome = Outcome::NO_WIN;
+      while(outcome == Outcome::NO_WIN) {
+        f.get_free_vertices(fcells);
+        b.get_free_vertices(bcells);
+        assert(fcells == bcells);
+        assert(f.count_free_vertices() == b.count_free_vertices());
+        assert(f.get_current_player() == b.get_current_player());
+        assert(f.is_victory(Color::BLUE) == b.is_victory(Color::BLUE));
+        assert(f.is_victory(Color::RED) == b.is_victory(Color::RED));
+
+        // a board copied from the position of b is the same board
+        FixedHexBoard<N> copy;
+        copy.set_position(topo, b.get_position());
+        for(vertID v=0; v<f.get_nodes(); ++v)
+          assert(copy.get_vertex_key(v) == f.get_vertex_key(v));
+        assert(copy.get_current_player() == f.get_current_player());
+
+        if(f.get_move_count() > 0 && gen() % 4 == 0) {
+          f.undo();
+          b.undo();
+          continue;
+        }
+        vertID v = fcells[gen() % fcells.size()];
+        outcome = f.play_vertex(v);
+        assert(b.play_vertex(v) == outcome);
+        assert(f.play_vertex(v) == Outcome::OCC_ERROR);
+      }
+      assert(f.is_victory(Color::BLUE) == b.is_victory(Color::BLUE));
+      assert(f.is_victory(Color::RED) == b.is_victory(Color::RED));
+    }
+
+    // full boards (as in the playouts): exactly one player has won
+    for(unsigned game=0; game<100; ++game) {
+      f.reset_board();
+      b.reset_board();
+      f.get_free_vertices(fcells);
+      shuffle(fcells.begin(), fcells.end(), gen);
+      for(unsigned i=0; i<fcells.size(); ++i) {
+        Color sym = (i%2 == 0) ? Color::BLUE : Color::RED;
+        f.set_vertex_key(fcells[i], sym);
+        b.set_vertex_key(fcells[i], sym);
+      }
+      assert(f.is_victory(Color::BLUE) != f.is_victory(Color::RED));
+      assert(f.is_victory(Color::BLUE) == b.is_victory(Color::BLUE));
+    }
+    return true;
+  }
+
+  bool run_generic(unsigned) { return false; }
+};
+
+// Generates G(n,p) graphs for extreme values of p: no edges when p is
+// too small for log(1-p) to tell it from 0, every pair when p is 1.
+void test_erdos_renyi(unsigned seed) {
+  typedef Graph<vertID,double> WGraph;
+  const unsigned n = 1000;
+  double probs[] = {0, 1e-19, 1e-300, 1};
+  for(unsigned i=0; i<sizeof(probs)/sizeof(probs[0]); ++i) {
+    WGraph g;
+    GraphSink<WGraph> sink(g);
+    generate(ErdosRenyi(n, probs[i]), sink, seed, 2);
+    assert(g.get_nodes() == n);
+    assert(g.get_edges() == (probs[i] < 1 ? 0 : n*(n-1)/2));
+  }
+  cout << "  G(" << n << ",p): no edges for tiny p, all of them for p = 1"
+       << endl;
+}
+
+int main(int argc, char** argv) {
+  unsigned seed = (argc > 1) ? atoi(argv[1]) : 1;
+
+  cout << "playouts" << endl;
+  unsigned dims[] = {3, 11, BB_MAX_DIM, BB_MAX_DIM+2, 25};
+  for(unsigned i=0; i<sizeof(dims)/sizeof(dims[0]); ++i)
+    test_playout(dims[i], seed+i);
+
+  cout << "board files" << endl;
+  test_board_file(11);
+
+  cout << "packed positions" << endl;
+  test_packed_positions<4>(seed);
+  test_packed_positions<11>(seed);
+
+  cout << "fixed boards" << endl;
+  unsigned checked = 0;
+  for(unsigned dim=3; dim<=FIXED_MAX_DIM+2; ++dim) {
+    FixedBoardCheck check = {seed+dim};
+    checked += dispatch_board_size(dim, check);
+  }
+  assert(checked == FIXED_MAX_DIM-2);
+  cout << "  " << checked << " sizes agree with HexBoard" << endl;
+
+  cout << "generators" << endl;
+  test_erdos_renyi(seed);
+
+  cout << "all tests passed" << endl;
+  return 0;
+}
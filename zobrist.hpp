@@ -0,0 +1,47 @@
+// -------------------------------------------------------------------
+// zobrist.hpp
+//
+// ZobristTable: random 64-bit keys for Zobrist hashing. The hash of a
+// position is the XOR of the keys of  every (vertex, player) pair that
+// holds a stone, plus the side key when  the second player is to move.
+// Because XOR is its own inverse, placing or removing a stone (or
+// passing the turn) updates the hash with a single XOR.  The keys come
+// from a fixed seed, so the same position always gets the same hash,
+// across runs and machines.
+// author: Luiz Ramos
+
+#ifndef ZOBRIST_HPP
+#define ZOBRIST_HPP
+
+#include <vector>
+#include <random>  // mt19937_64
+#include <cstdint> // uint64_t
+#include "graph.hpp"
+using namespace std;
+
+class ZobristTable {
+private:
+  vector<uint64_t> keys; // two keys per vertex (one per player)
+  uint64_t side; // key of "second player to move"
+
+public:
+  ZobristTable(): side(0) {}
+
+  // generates the keys for a graph with 'nodes' vertices
+  void reset(unsigned nodes) {
+    // mt19937_64 is fully specified by the standard, so the sequence (and
+    // therefore every hash) is reproducible; mixing in the number of
+    // vertices gives each board size its own table
+    mt19937_64 gen(0x9e3779b97f4a7c15ULL ^ nodes);
+    keys.resize(2 * nodes);
+    for(unsigned i=0; i<keys.size(); ++i)
+      keys[i] = gen();
+    side = gen();
+  }
+
+  // key of a stone of 'player' (0 or 1) on vertex v
+  uint64_t stone(vertID v, int player) const { return keys[2*v + player]; }
+  // key toggled whenever the turn changes
+  uint64_t get_side() const { return side; }
+};
+#endif